@@ -0,0 +1,20 @@
+#!/bin/bash
+
+#-eq must not change the verdict, in particular on designs with constraints:
+#eq_constraint is safe only because its constraint rules out the path to bad,
+#eq_constraint_init because its constraint is false in the initial state while bad is constant true
+arr=("eq_constraint" "eq_constraint_init")
+mkdir -p ../output/eq_compare/plain ../output/eq_compare/eq
+for var in ${arr[@]}
+do
+  for mode in "-b" "-f"
+  do
+    ./simplecar_minisat $mode ./cases/$var.aag ../output/eq_compare/plain/ -timeout 30
+    ./simplecar_minisat $mode -eq ./cases/$var.aag ../output/eq_compare/eq/ -timeout 30
+    plain=$(head -1 ../output/eq_compare/plain/$var.res)
+    eq=$(head -1 ../output/eq_compare/eq/$var.res)
+    if [ "$plain" != "$eq" ]; then
+      echo "$var $mode: $plain without -eq, $eq with -eq"
+    fi
+  done
+done
@@ -0,0 +1,22 @@
+#!/bin/bash
+
+#-unroll k must not change the verdict. unroll_depth1 reaches bad in one step from an initial state 
+#that has no predecessor, so a one-step query that also asks for the other k-1 steps misses it
+arr=("unroll_depth1")
+mkdir -p ../output/unroll_compare/plain ../output/unroll_compare/unroll
+for var in ${arr[@]}
+do
+  for mode in "-b" "-f"
+  do
+    ./simplecar_minisat $mode ./cases/$var.aag ../output/unroll_compare/plain/ -timeout 30
+    plain=$(head -1 ../output/unroll_compare/plain/$var.res)
+    for k in 2 3
+    do
+      ./simplecar_minisat $mode -unroll $k ./cases/$var.aag ../output/unroll_compare/unroll/ -timeout 30
+      unroll=$(head -1 ../output/unroll_compare/unroll/$var.res)
+      if [ "$plain" != "$unroll" ]; then
+        echo "$var $mode: $plain without -unroll, $unroll with -unroll $k"
+      fi
+    done
+  done
+done
@@ -1,14 +1,21 @@
 #include "BackwardChecker.h"
 #include <stack>
 #include <string>
+#include <thread>
 
 namespace car
 {
-	BackwardChecker::BackwardChecker(Settings settings, std::shared_ptr<AigerModel> model) : m_settings(settings)
+	BackwardChecker::BackwardChecker(Settings settings, std::shared_ptr<AigerModel> model) : m_settings(settings), m_pendingTasks(0), m_exploreStopped(false)
 	{
+		if (m_settings.explore > 1)
+		{
+			//these keep state of their own along the working stack, which the workers do not share
+			m_settings.rotate = false;
+			m_settings.restart = false;
+			m_settings.Visualization = false;
+			m_settings.debug = false;
+		}
 		m_model = model;
-		State::numInputs = model->GetNumInputs();
-		State::numLatches = model->GetNumLatches(); 
 		m_log.reset(new Log(settings, model));
 		const std::vector<int>& init = model->GetInitialState();
 		std::shared_ptr<std::vector<int> > inputs(new std::vector<int>(State::numInputs, 0));
@@ -26,6 +33,10 @@ namespace car
 	{
 		for (int i = 0, maxI = m_model->GetOutputs().size(); i < maxI; ++i)
 		{
+			if (m_settings.property >= 0 && i != m_settings.property)
+			{
+				continue;
+			}
 			int badId = m_model->GetOutputs().at(i);
 			bool result = Check(badId);
 			//PrintUC();
@@ -40,8 +51,12 @@ namespace car
 			if (m_settings.Visualization) {
 				m_vis->OutputGML(false);
 			}
-			std:string ps = "repeated states num: " + std::to_string(m_repeat_state_num);
+			std:string ps = "repeated states num: " + std::to_string(m_underSequence.GetRepeats());
 			m_log->PrintSth(ps);
+			if (m_settings.explore > 1)
+			{
+				m_log->PrintSth("stolen tasks: " + std::to_string(m_steals));
+			}
 			m_log->PrintStatistics();
 		}
 		return true;
@@ -50,15 +65,19 @@ namespace car
 	bool BackwardChecker::Check(int badId)
 	{
 #pragma region early stage
-		if (m_model->GetTrueId() == badId)
+		//a bad that is constant true still goes through the queries below, 
+		//as the constraints may hold in no initial state
+		if (m_model->GetFalseId() == badId)
 		{
 			//placeholder
-			return false;
+			return true;
 		}
-		else if (m_model->GetFalseId() == badId)
+
+		//only the cone of bad is encoded, and the states only keep its latches
+		m_model->SetCone(badId);
+		if (m_settings.simplify)
 		{
-			//placeholder
-			return true;
+			m_model->Simplify();
 		}
 
  		Init();
@@ -89,15 +108,14 @@ namespace car
 			//placeholder
 			return true;
 		}
-		m_overSequence->Insert(uc, 0);
+		m_overSequence->Insert(*uc, 0);
 		if (m_settings.debug)
 		{
 			m_log->PrintUcNums(*uc, m_overSequence.get()); //debug
 		}
 		
-		std::vector<std::shared_ptr<std::vector<int> > > frame;
-		m_overSequence->GetFrame(0, frame);
-		m_mainSolver->AddNewFrame(frame, 0);
+		FrameView frame = m_overSequence->GetFrame(0);
+		AddNewFrame(frame, 0);
 		m_overSequence->effectiveLevel = 0;
 # pragma endregion 
 
@@ -108,7 +126,15 @@ namespace car
 		{
 			m_log->PrintFramesInfo(m_overSequence.get());
 			m_minUpdateLevel = m_overSequence->GetLength();
-			if (m_settings.end)
+			if (m_settings.explore > 1)
+			{
+				m_badId = badId;
+				if (!ExploreLevel(frameStep))
+				{
+					return false;
+				}
+			}
+			else if (m_settings.end)
 			{
 				for (int i = 0; i < m_underSequence.size(); ++i)
 				{
@@ -130,7 +156,7 @@ namespace car
 					if (m_settings.Visualization) {
 						m_vis->OutputGML(true);
 					}
-					std:string ps = "repeated states num: " + std::to_string(m_repeat_state_num);
+					std:string ps = "repeated states num: " + std::to_string(m_underSequence.GetRepeats());
 					m_log->PrintSth(ps);
 					m_log->PrintSth("time out!!!");
 					m_log->Timeout();
@@ -161,7 +187,8 @@ namespace car
  				if (task.frameLevel == -1)
 				{ 
 					m_log->Tick();
-					std::vector<int> assumption;
+					std::vector<int>& assumption = m_assumption;
+					assumption.clear();
 					GetAssumption(task.state, task.frameLevel, assumption);
 					if (m_settings.debug)
 					{
@@ -169,6 +196,7 @@ namespace car
 					}
 					bool result = m_mainSolver->SolveWithAssumptionAndBad(assumption, badId);
 					m_log->StatMainSolver();
+					CheckDecided(*m_mainSolver);
 					if (result)
 					{
 						std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > > pair;
@@ -204,7 +232,7 @@ namespace car
  						task.frameLevel++;
 						 //notes 4
 						 /*
-						if (task.frameLevel+1 >= m_overSequence->GetLength() || !m_overSequence->IsBlockedByFrame(*(task.state->latches), task.frameLevel+1))
+						if (task.frameLevel+1 >= m_overSequence->GetLength() || !m_overSequence->IsBlockedByFrame(task.state->latches, task.frameLevel+1))
 						{
 							task.isLocated = true;
 						}
@@ -220,14 +248,41 @@ namespace car
 				m_log->Tick();
 
 	
-				std::vector<int> assumption;
+				std::vector<int>& assumption = m_assumption;
+				assumption.clear();
 				GetAssumption(task.state, task.frameLevel, assumption);
 				if (m_settings.debug)
 				{
 					m_log->PrintSAT(assumption, task.frameLevel);
 				}
-				bool result = m_mainSolver->SolveWithAssumption(assumption, task.frameLevel);
+				bool result;
+				if (m_settings.unroll > 1)
+				{
+					//look k steps ahead first, the lemma still comes from the one-step query below
+					result = m_mainSolver->SolveWithAssumptionUnroll(assumption, task.frameLevel);
+					m_log->StatMainSolver();
+					if (result)
+					{
+						std::shared_ptr<State> preState = task.state;
+						auto steps = m_mainSolver->GetUnrollAssignment();
+						for (auto& pair : steps)
+						{
+							std::shared_ptr<State> newState(new State (preState, pair.first, pair.second, preState->depth+1));
+							std::shared_ptr<State> pushed = m_underSequence.push(newState);
+							if (m_settings.Visualization && pushed == newState) {
+								m_vis->addState(newState);
+							}
+							preState = pushed;
+						}
+						int newFrameLevel = GetNewLevel(preState);
+						workingStack.emplace(preState, newFrameLevel, true);
+						continue;
+					}
+					m_log->Tick();
+				}
+				result = m_mainSolver->SolveWithAssumption(assumption, task.frameLevel);
 				m_log->StatMainSolver();
+				CheckDecided(*m_mainSolver);
 				if (result)
 				{
 					//Solver return SAT, get a new State, then continue
@@ -241,11 +296,12 @@ namespace car
 						pair = m_mainSolver->GetAssignment();
 					}
 					std::shared_ptr<State> newState(new State (task.state, pair.first, pair.second, task.state->depth+1));
-					// if (m_underSequence.isRepeatedState(newState)) m_repeat_state_num++;
-					m_underSequence.push(newState);   
-					if (m_settings.Visualization) {
+					//a state reached again goes on as the one reached first
+					std::shared_ptr<State> pushed = m_underSequence.push(newState);
+					if (m_settings.Visualization && pushed == newState) {
 						m_vis->addState(newState);
-					}                              
+					}
+					newState = pushed;
 					int newFrameLevel = GetNewLevel(newState);
 					workingStack.emplace(newState, newFrameLevel, true);
 					continue;
@@ -270,7 +326,7 @@ namespace car
 					task.frameLevel++;
 					//notes 4
 					/*
-					if (task.frameLevel+1 < m_overSequence->GetLength() && !m_overSequence->IsBlockedByFrame(*(task.state->latches), task.frameLevel+1))
+					if (task.frameLevel+1 < m_overSequence->GetLength() && !m_overSequence->IsBlockedByFrame(task.state->latches, task.frameLevel+1))
 					{
 						task.isLocated = true;
 					}
@@ -287,10 +343,9 @@ namespace car
 			{
 				Propagation();
 			}
-			std::vector<std::shared_ptr<std::vector<int> > > lastFrame;
 			frameStep++;
-			m_overSequence->GetFrame(frameStep, lastFrame);
-			m_mainSolver->AddNewFrame(lastFrame, frameStep);
+			FrameView lastFrame = m_overSequence->GetFrame(frameStep);
+			AddNewFrame(lastFrame, frameStep);
 			m_overSequence->effectiveLevel++;
 			m_restart->ResetUcCounts();
 			
@@ -323,11 +378,31 @@ namespace car
 			m_vis.reset(new Vis(m_settings, m_model));
 			m_vis->addState(m_initialState);
 		}
-		m_mainSolver.reset(new MainSolver(m_model, false, m_settings.muc));
-		m_invSolver.reset(new InvSolver(m_model));
+		//the cubes of another property range over the latches of its cone
+		m_rotation.clear();
+		m_mainSolver = NewMainSolver(m_settings.mainSat, m_model, false, m_settings.muc, m_settings.unroll, m_log->GetTrace("main"));
+		m_invSolver.reset(new InvSolver(m_model, m_settings.invSat, m_log->GetTrace("inv")));
 		m_log->ResetClock();
+		ApplyLimits(*m_mainSolver);
+		ApplyLimits(m_invSolver->GetSolver());
 		m_restart.reset(new Restart(m_settings));
-		m_repeat_state_num = 0;
+		m_workers.clear();
+		for (int i = 0; m_settings.explore > 1 && i < m_settings.explore; ++i)
+		{
+			std::shared_ptr<ExploreWorker> worker(new ExploreWorker());
+			if (i == 0)
+			{
+				worker->solver = m_mainSolver;
+			}
+			else
+			{
+				//a trace is written by one thread only
+				worker->solver = NewMainSolver(m_settings.mainSat, m_model, false, m_settings.muc, m_settings.unroll, m_log->GetTrace("main" + std::to_string(i)));
+				ApplyLimits(*worker->solver);
+			}
+			m_workers.push_back(worker);
+		}
+		m_cexState = nullptr;
 	}
 
 	void BackwardChecker::AddUnsatisfiableCore(std::shared_ptr<std::vector<int> > uc, int frameLevel)
@@ -335,48 +410,349 @@ namespace car
 		if (frameLevel <= m_overSequence->effectiveLevel)
 		{
 			m_mainSolver->AddUnsatisfiableCore(*uc, frameLevel);
+			for (int i = 1; i < m_workers.size(); ++i)
+			{
+				m_workers[i]->solver->AddUnsatisfiableCore(*uc, frameLevel);
+			}
 		}
-		m_overSequence->Insert(uc, frameLevel);
+		m_overSequence->Insert(*uc, frameLevel);
 		if(frameLevel < m_minUpdateLevel)
 		{
 			m_minUpdateLevel = frameLevel;
 		}
 	}
 
+	void BackwardChecker::AddNewFrame(const FrameView& frame, int frameLevel)
+	{
+		m_mainSolver->AddNewFrame(frame, frameLevel);
+		for (int i = 1; i < m_workers.size(); ++i)
+		{
+			m_workers[i]->solver->AddNewFrame(frame, frameLevel);
+		}
+	}
+
+	bool BackwardChecker::ExploreLevel(int frameStep)
+	{
+		//the same tasks the working stack starts with, dealt out to the workers
+		std::vector<std::shared_ptr<State> > states;
+		if (m_settings.end)
+		{
+			for (int i = m_underSequence.size()-1; i >= 0; --i)
+			{
+				states.insert(states.end(), m_underSequence[i].begin(), m_underSequence[i].end());
+			}
+		}
+		else
+		{
+			states.push_back(m_underSequence[0][0]);
+		}
+		for (int i = 0; i < states.size(); ++i)
+		{
+			PushTask(*m_workers[i % m_workers.size()], Task(states[i], frameStep, false));
+		}
+
+		m_exploreStopped = false;
+		std::vector<std::thread> threads;
+		for (int i = 0; i < m_workers.size(); ++i)
+		{
+			threads.emplace_back(&BackwardChecker::Explore, this, i);
+		}
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+		for (auto& worker : m_workers)
+		{
+			TakeInbox(*worker);
+			worker->tasks.clear();
+			m_steals += worker->steals;
+			worker->steals = 0;
+		}
+		m_pendingTasks = 0;
+
+		if (m_cexState != nullptr)
+		{
+			m_log->lastState = m_cexState;
+			return false;
+		}
+		if (m_exploreStopped)
+		{
+			std::string ps = "repeated states num: " + std::to_string(m_underSequence.GetRepeats());
+			m_log->PrintSth(ps);
+			m_log->PrintSth("time out!!!");
+			m_log->Timeout();
+		}
+		return true;
+	}
+
+	void BackwardChecker::Explore(int id)
+	{
+		ExploreWorker& worker = *m_workers[id];
+		Task task(nullptr, 0, false);
+		while (!m_exploreStopped)
+		{
+			if (m_settings.timelimit > 0 && m_log->IsTimeout())
+			{
+				StopExploring(nullptr);
+				return;
+			}
+			if (!PopTask(id, task))
+			{
+				if (m_pendingTasks == 0)
+				{
+					return;
+				}
+				std::this_thread::yield();
+				continue;
+			}
+			TakeInbox(worker);
+			ExploreTask(worker, task);
+			//after the tasks it pushed, so that the count only gets to 0 once every worker is out of work
+			--m_pendingTasks;
+		}
+	}
+
+	void BackwardChecker::ExploreTask(ExploreWorker& worker, Task& task)
+	{
+		if (!task.isLocated)
+		{
+			std::lock_guard<std::mutex> lock(m_sequenceMutex);
+			task.frameLevel = GetNewLevel(task.state, task.frameLevel+1);
+			if (task.frameLevel > m_overSequence->effectiveLevel)
+			{
+				return;
+			}
+		}
+		task.isLocated = false;
+
+		std::vector<int>& assumption = worker.assumption;
+		assumption.clear();
+		{
+			//-inter reads the frames
+			std::lock_guard<std::mutex> lock(m_sequenceMutex);
+			GetAssumption(task.state, task.frameLevel, assumption);
+		}
+		bool result;
+		if (task.frameLevel == -1)
+		{
+			result = worker.solver->SolveWithAssumptionAndBad(assumption, m_badId);
+		}
+		else
+		{
+			if (m_settings.unroll > 1)
+			{
+				result = worker.solver->SolveWithAssumptionUnroll(assumption, task.frameLevel);
+				if (result)
+				{
+					std::shared_ptr<State> preState = task.state;
+					auto steps = worker.solver->GetUnrollAssignment();
+					{
+						std::lock_guard<std::mutex> lock(m_exploreMutex);
+						for (auto& pair : steps)
+						{
+							std::shared_ptr<State> newState(new State (preState, pair.first, pair.second, preState->depth+1));
+							preState = m_underSequence.push(newState);
+						}
+					}
+					int newFrameLevel;
+					{
+						std::lock_guard<std::mutex> lock(m_sequenceMutex);
+						newFrameLevel = GetNewLevel(preState);
+					}
+					PushTask(worker, task);
+					if (newFrameLevel < task.frameLevel)
+					{
+						PushTask(worker, Task(preState, newFrameLevel, true));
+					}
+					return;
+				}
+			}
+			result = worker.solver->SolveWithAssumption(assumption, task.frameLevel);
+		}
+		if (worker.solver->GetLastResult() == SolveResult::Unknown)
+		{
+			StopExploring(nullptr);
+			return;
+		}
+
+		if (result)
+		{
+			auto pair = worker.solver->GetAssignment();
+			std::shared_ptr<State> newState(new State (task.state, pair.first, pair.second, task.state->depth+1));
+			if (task.frameLevel == -1)
+			{
+				StopExploring(newState);
+				return;
+			}
+			{
+				//a state reached again goes on as the one reached first
+				std::lock_guard<std::mutex> lock(m_exploreMutex);
+				newState = m_underSequence.push(newState);
+			}
+			int newFrameLevel;
+			{
+				std::lock_guard<std::mutex> lock(m_sequenceMutex);
+				newFrameLevel = GetNewLevel(newState);
+			}
+			PushTask(worker, task);
+			//a uc of another worker that is not in the solver yet may block the state at the level of the query,
+			//then the task asks again once the solver has it
+			if (newFrameLevel < task.frameLevel)
+			{
+				PushTask(worker, Task(newState, newFrameLevel, true));
+			}
+		}
+		else
+		{
+			PublishUnsatisfiableCore(worker, worker.solver->GetUnsatisfiableCore(), task.frameLevel+1);
+			task.frameLevel++;
+			PushTask(worker, task);
+		}
+	}
+
+	bool BackwardChecker::PopTask(int id, Task& task)
+	{
+		{
+			ExploreWorker& worker = *m_workers[id];
+			std::lock_guard<std::mutex> lock(worker.mutex);
+			if (!worker.tasks.empty())
+			{
+				task = worker.tasks.back();
+				worker.tasks.pop_back();
+				return true;
+			}
+		}
+		for (int i = 1; i < m_workers.size(); ++i)
+		{
+			ExploreWorker& victim = *m_workers[(id + i) % m_workers.size()];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.tasks.empty())
+			{
+				task = victim.tasks.front();
+				victim.tasks.pop_front();
+				++m_workers[id]->steals;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void BackwardChecker::PushTask(ExploreWorker& worker, const Task& task)
+	{
+		++m_pendingTasks;
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		worker.tasks.push_back(task);
+	}
+
+	void BackwardChecker::PublishUnsatisfiableCore(ExploreWorker& worker, std::shared_ptr<std::vector<int> > uc, int frameLevel)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_sequenceMutex);
+			m_overSequence->Insert(*uc, frameLevel);
+			if (frameLevel < m_minUpdateLevel)
+			{
+				m_minUpdateLevel = frameLevel;
+			}
+		}
+		//the effective level does not change while the workers run
+		if (frameLevel > m_overSequence->effectiveLevel)
+		{
+			return;
+		}
+		worker.solver->AddUnsatisfiableCore(*uc, frameLevel);
+		for (auto& other : m_workers)
+		{
+			if (other.get() != &worker)
+			{
+				std::lock_guard<std::mutex> lock(other->mutex);
+				other->inbox.emplace_back(*uc, frameLevel);
+			}
+		}
+	}
+
+	void BackwardChecker::TakeInbox(ExploreWorker& worker)
+	{
+		std::vector<std::pair<std::vector<int>, int> > inbox;
+		{
+			std::lock_guard<std::mutex> lock(worker.mutex);
+			inbox.swap(worker.inbox);
+		}
+		for (auto& uc : inbox)
+		{
+			worker.solver->AddUnsatisfiableCore(uc.first, uc.second);
+		}
+	}
+
+	void BackwardChecker::StopExploring(std::shared_ptr<State> cexState)
+	{
+		std::lock_guard<std::mutex> lock(m_exploreMutex);
+		if (cexState != nullptr && m_cexState == nullptr)
+		{
+			m_cexState = cexState;
+		}
+		m_exploreStopped = true;
+		//the queries still running give up, and so does every later one of the check
+		for (auto& worker : m_workers)
+		{
+			worker->solver->Interrupt();
+		}
+	}
+
+	void BackwardChecker::ApplyLimits(ISolver& solver)
+	{
+		solver.SetBudget(m_settings.conflictBudget, m_settings.propagationBudget);
+		solver.SetMucBudget(m_settings.mucBudget);
+		if (m_settings.timelimit > 0)
+		{
+			solver.SetDeadline(m_log->GetDeadline());
+		}
+		if (m_settings.worker >= 0 || m_settings.property >= 0)
+		{
+			solver.SetStopFlag(m_log->GetStopFlag());
+		}
+	}
+
+	void BackwardChecker::CheckDecided(ISolver& solver)
+	{
+		if (solver.GetLastResult() == SolveResult::Unknown)
+		{
+			if (m_settings.Visualization) {
+				m_vis->OutputGML(true);
+			}
+			m_log->PrintSth("time out!!!");
+			m_log->Timeout();
+		}
+	}
+
 	bool BackwardChecker::ImmediateSatisfiable(int badId)
 	{
-		std::vector<int>& init = *(m_initialState->latches);
+		std::shared_ptr<std::vector<int> > init = m_initialState->GetLatches();
 		std::vector<int> assumptions;
-		assumptions.resize((init.size()));
-		std::copy(init.begin(), init.end(), assumptions.begin());
+		assumptions.resize((init->size()));
+		std::copy(init->begin(), init->end(), assumptions.begin());
 		//assumptions[assumptions.size()-1] = badId;
 		bool result = m_mainSolver->SolveWithAssumptionAndBad(assumptions, badId);
+		CheckDecided(*m_mainSolver);
 		return result;
 	}
 
 	bool BackwardChecker::isInvExisted()
 	{
-		if (m_invSolver == nullptr)
-		{
-			m_invSolver.reset(new InvSolver(m_model));
-		}
-		bool result = false;
 		for (int i = 0; i < m_overSequence->GetLength(); ++i)
 		{
 			if (IsInvariant(i))
 			{
-				result = true;
+				return true;
 			}
 		}
-		m_invSolver = nullptr;
-		return result;
+		return false;
 	}
 
 	int BackwardChecker::GetNewLevel(std::shared_ptr<State> state, int start)
 	{
 		for (int i = start; i < m_overSequence->GetLength(); ++i)
 		{
-			if (!m_overSequence->IsBlockedByFrame(*(state->latches), i))
+			if (!m_overSequence->IsBlockedByFrame(state->latches, i))
 			{
 				return i-1;
 			}
@@ -386,19 +762,24 @@ namespace car
 
 	bool BackwardChecker::IsInvariant(int frameLevel)
 	{
-		std::vector<std::shared_ptr<std::vector<int> > > frame;
-		m_overSequence->GetFrame(frameLevel, frame);
+		FrameView frame = m_overSequence->GetFrame(frameLevel);
 
 		if (frameLevel < m_minUpdateLevel)
 		{
-			m_invSolver->AddConstraintOr(frame);
+			//not updated since the last check, so the solver already has it
+			if (!m_invSolver->IsEncoded(frameLevel))
+			{
+				m_invSolver->UpdateFrame(frame, frameLevel);
+			}
 			return false;
 		}
 
-		m_invSolver->AddConstraintAnd(frame);
- 		bool result = !m_invSolver->SolveWithAssumption();
-		m_invSolver->FlipLastConstrain();
-		m_invSolver->AddConstraintOr(frame);
+		if (m_overSequence->IsSyntacticFixpoint(frameLevel))
+		{
+			return true;
+		}
+		bool result = m_invSolver->IsContained(frame, frameLevel);
+		m_invSolver->UpdateFrame(frame, frameLevel);
 		return result;
 	}
 
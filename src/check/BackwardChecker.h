@@ -15,6 +15,9 @@
 #include "Vis.h"
 #include <assert.h>
 #include <memory>
+#include <deque>
+#include <mutex>
+#include <atomic>
 #include "restart.h"
 
 
@@ -28,12 +31,56 @@ class BackwardChecker : public BaseChecker
 public:
 	BackwardChecker(Settings settings, std::shared_ptr<AigerModel> model);
 	bool Run();
+	void Stop() {m_log->Stop();}
+	void ExtendTimelimit(double seconds) {m_log->ExtendTimelimit(seconds);}
 	bool Check(int badId);
 private:
+	//a thread of the parallel exploration (-explore), with a main solver of its own
+	struct ExploreWorker
+	{
+		std::shared_ptr<ISolver> solver;
+		std::vector<int> assumption;
+		std::mutex mutex;//guards tasks and inbox
+		std::deque<Task> tasks;//the owner works at the back like on the stack, the others steal from the front
+		std::vector<std::pair<std::vector<int>, int> > inbox;//the ucs of the others and their levels, not in solver yet
+		int steals = 0;
+	};
+
 	void Init();
 
 	void AddUnsatisfiableCore(std::shared_ptr<std::vector<int> > uc, int frameLevel);
 
+	//to every main solver, there is one per thread of the exploration
+	void AddNewFrame(const FrameView& frame, int frameLevel);
+
+	//explores the states of the current level on the threads of -explore, as the working stack does alone.
+	//false iff a counterexample is found, a query that gives up ends the check as a timeout
+	bool ExploreLevel(int frameStep);
+
+	void Explore(int worker);
+
+	//one step of the task, which goes back to the worker unless it is done
+	void ExploreTask(ExploreWorker& worker, Task& task);
+
+	//the worker's own newest task, else the oldest one of another worker
+	bool PopTask(int worker, Task& task);
+
+	void PushTask(ExploreWorker& worker, const Task& task);
+
+	//the uc goes into the frames and the worker's solver at once, into the other solvers before their next query
+	void PublishUnsatisfiableCore(ExploreWorker& worker, std::shared_ptr<std::vector<int> > uc, int frameLevel);
+
+	void TakeInbox(ExploreWorker& worker);
+
+	//ends the exploration of the level, with the last state of a counterexample or without one if a query gave up
+	void StopExploring(std::shared_ptr<State> cexState);
+
+	//the query budgets and the deadline of the check, for a new solver
+	void ApplyLimits(ISolver& solver);
+
+	//a query that gave up leaves no sound way on, so the check ends as a timeout
+	void CheckDecided(ISolver& solver);
+
 	bool ImmediateSatisfiable(int badId);
 
 	bool isInvExisted();
@@ -58,26 +105,24 @@ private:
 		return filePath.substr(startIndex, endIndex-startIndex);	
 	}
 
-	void GetPriority (std::shared_ptr<std::vector<int> > latches, const int frameLevel, std::vector<int>& res) 
+	void GetPriority (std::shared_ptr<State> state, const int frameLevel, std::vector<int>& res) 
 	{    
 		if (frameLevel+1 >= m_overSequence->GetLength())
 		{
 			return;
 		}
-	    std::vector<std::shared_ptr<std::vector<int> > > frame;
-		m_overSequence->GetFrame(frameLevel+1, frame);
-	    if (frame.size () == 0)  
+	    if (m_overSequence->GetFrameSize(frameLevel+1) == 0)  
 		{
 	    	return;
 		}
 	    	
-	    std::shared_ptr<std::vector<int> > uc = frame[frame.size()-1];
-	    res.reserve (uc->size());
-	    for (int i = 0; i < uc->size() ; ++ i) 
+	    Lemma uc = m_overSequence->GetFrame(frameLevel+1).back();
+	    res.reserve (uc.size());
+	    for (int i = 0; i < uc.size() ; ++ i) 
 		{
-	    	if ((*latches)[abs((*uc)[i])-m_model->GetNumInputs()-1] == (*uc)[i]) 
+	    	if (state->HasLiteral(uc[i])) 
 			{
-	    		res.push_back ((*uc)[i]);
+	    		res.push_back (uc[i]);
 	    	}
 	    }
 	}
@@ -87,38 +132,27 @@ private:
 	{
 		if (m_settings.inter)
 		{
-			GetPriority(state->latches, frameLevel, ass);
+			GetPriority(state, frameLevel, ass);
 		}
 
-		ass.reserve(ass.size() + state->latches->size());
+		ass.reserve(ass.size() + State::numLatches);
 
-		if (m_settings.rotate)
+		if (m_settings.rotate && frameLevel + 2 <= m_rotation.size() && m_rotation[frameLevel+1] != nullptr)
 		{
-			std::vector<int> tmp;
-			tmp.reserve (state->latches->size());
-			int aa = m_rotation.size();
-			if (frameLevel + 2 > m_rotation.size()) 
-			{
-				ass.insert(ass.end(), state->latches->begin(), state->latches->end());
-				return;
-			}
-			else if (m_rotation[frameLevel+1] == nullptr)
-			{
-				ass.insert(ass.end(), state->latches->begin(), state->latches->end());
-				return;
-			}
+			//the literals the state shares with the cube first, then the ones it flips
 			std::vector<int>& cube = *m_rotation[frameLevel+1];
 			for (int i = 0; i < cube.size (); ++ i) {
-				if ((*state->latches)[abs(cube[i])-m_model->GetNumInputs()-1] == cube[i]) 
+				if (state->HasLiteral(cube[i])) 
 					ass.push_back (cube[i]);
-				else
-					tmp.push_back (-cube[i]);
 			}
-			ass.insert(ass.end(), tmp.begin(), tmp.end());
+			for (int i = 0; i < cube.size (); ++ i) {
+				if (!state->HasLiteral(cube[i])) 
+					ass.push_back (-cube[i]);
+			}
 		}
 		else
 		{
-			ass.insert(ass.end(), state->latches->begin(), state->latches->end());
+			state->AppendLatches(ass);
 		}
 	}
 
@@ -128,7 +162,7 @@ private:
 		{
 			m_rotation.push_back(nullptr);
 		}
-		m_rotation[frameLevel+1] = state->latches;
+		m_rotation[frameLevel+1] = state->GetLatches();
 	}
 
 	void Propagation()
@@ -136,22 +170,28 @@ private:
 		OverSequenceForProp* sequence = dynamic_cast<OverSequenceForProp*>(m_overSequence.get());
 		for (int frameLevel = 0; frameLevel < sequence->GetLength()-1; ++frameLevel)
 		{
-			std::vector<std::shared_ptr<std::vector<int> > > unpropFrame = sequence->GetUnProp(frameLevel);
-			std::vector<std::shared_ptr<std::vector<int> > > propFrame = sequence->GetProp(frameLevel);
+			//inserting below modifies the frames, so take the ucs out of the arena first
+			FrameView unprop = sequence->GetUnProp(frameLevel);
+			std::vector<std::shared_ptr<std::vector<int> > > unpropFrame;
+			unpropFrame.reserve(unprop.size());
+			for (int j = 0; j < unprop.size(); ++j)
+			{
+				unpropFrame.push_back(unprop[j].ToVector());
+			}
 			std::vector<std::shared_ptr<std::vector<int> > > tmp;
 			for (int j = 0; j < unpropFrame.size(); ++j)
 			{	
-				if (sequence->IsBlockedByFrame(*unpropFrame[j], frameLevel+1))
+				if (sequence->IsBlockedByFrame(PackedState(*unpropFrame[j], m_model->GetNumInputs(), m_model->GetNumLatches()), frameLevel+1))
 				{
-					propFrame.push_back(unpropFrame[j]);
 					continue;
 				}
 
 				bool result = m_mainSolver->SolveWithAssumption(*unpropFrame[j], frameLevel);
-				if (!result)
+				//a query that gave up leaves the lemma unpropagated
+				if (!result && m_mainSolver->GetLastResult() == SolveResult::Unsat)
 				{
 					AddUnsatisfiableCore(unpropFrame[j], frameLevel+1);
-					sequence->InsertIntoProped(unpropFrame[j], frameLevel);
+					sequence->InsertIntoProped(*unpropFrame[j], frameLevel);
 				}
 				else
 				{
@@ -173,10 +213,19 @@ private:
 	std::shared_ptr<AigerModel> m_model;
 	std::shared_ptr<State> m_initialState;
 	std::shared_ptr<ISolver> m_mainSolver;
-	std::shared_ptr<ISolver> m_invSolver;
+	std::shared_ptr<InvSolver> m_invSolver;
+	std::vector<int> m_assumption;//refilled by GetAssumption for every query, so its storage is reused
 	std::vector<std::shared_ptr<std::vector<int> > > m_rotation;
 	std::shared_ptr<Restart> m_restart;
-	int m_repeat_state_num = 0;
+
+	int m_badId;
+	std::vector<std::shared_ptr<ExploreWorker> > m_workers;//empty unless -explore
+	std::mutex m_sequenceMutex;//guards the frames and m_minUpdateLevel while the workers run
+	std::mutex m_exploreMutex;//guards the under sequence and m_cexState
+	std::atomic<int> m_pendingTasks;//queued or in the hands of a worker, the level is done at 0
+	std::atomic<bool> m_exploreStopped;
+	std::shared_ptr<State> m_cexState;
+	int m_steals = 0;
 };
 
 }//namespace car
@@ -11,6 +11,11 @@ namespace car
     {
     public:
         virtual bool Run() = 0;
+        //makes a running Run() give up at its next query, safe to call from another thread
+        virtual void Stop() = 0;
+        //gives a running Run() this many more seconds, safe to call from another thread.
+        //a check that runs others rather than one of its own has no time limit to extend
+        virtual void ExtendTimelimit(double seconds) {}
         virtual ~BaseChecker(){};
     };
 
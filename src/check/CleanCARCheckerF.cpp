@@ -7,8 +7,6 @@ namespace car
 	CleanCARCheckerF::CleanCARCheckerF(Settings settings, std::shared_ptr<AigerModel> model) : m_settings(settings)
 	{
 		m_model = model;
-		State::numInputs = model->GetNumInputs();
-		State::numLatches = model->GetNumLatches(); 
 		m_log.reset(new Log(settings, model));
 
 		const std::vector<int>& init = model->GetInitialState();
@@ -25,6 +23,7 @@ namespace car
 	bool CleanCARCheckerF::Run()
 	{
 		for (int i = 0, maxI = m_model->GetOutputs().size(); i < maxI; ++i)	{
+			if (m_settings.property >= 0 && i != m_settings.property) continue;
 			int badId = m_model->GetOutputs().at(i);
 			bool result = Check(badId);
 
@@ -40,8 +39,16 @@ namespace car
 	{
 #pragma region early stage
     // bad is constantly true or false
-		if (m_model->GetTrueId() == badId) return false;
-		else if (m_model->GetFalseId() == badId) return true;
+		//a bad that is constant true still goes through the queries below, 
+		//as the constraints may hold in no initial state
+		if (m_model->GetFalseId() == badId) return true;
+
+		//only the cone of bad is encoded, and the states only keep its latches
+		m_model->SetCone(badId);
+		if (m_settings.simplify)
+		{
+			m_model->Simplify();
+		}
 
  		Init(badId);
 
@@ -51,21 +58,24 @@ namespace car
 #else
 			auto pair = m_mainSolver->GetAssignment();
 #endif
+			//bad in the initial state, under these inputs
+			m_initialState->preState = nullptr;
 			m_initialState->inputs = pair.first;
+			m_log->lastState = m_initialState;
 			return false;
 		}
 
-		for(auto latch:*(m_initialState->latches)){
+		std::shared_ptr<std::vector<int> > initLatches = m_initialState->GetLatches();
+		for(auto latch:*initLatches){
 			std::shared_ptr<std::vector<int>> puc(new std::vector<int> {-latch});
-			m_overSequence->Insert(puc, 0);
+			m_overSequence->Insert(*puc, 0);
 		}
 
 #ifdef __DEBUG__
 		m_log->PrintUcNums(uc, m_overSequence);
 #endif
 
-		std::vector<std::shared_ptr<std::vector<int> > > frame;
-		m_overSequence->GetFrame(0, frame);
+		FrameView frame = m_overSequence->GetFrame(0);
 		m_mainSolver->AddNewFrame(frame, 0);
 		m_overSequence->effectiveLevel = 0;
 		m_startSovler->UpdateStartSolverFlag();
@@ -114,18 +124,20 @@ namespace car
 					}
 					m_log->Tick();
 
-					//bool result = m_mainSolver->SolveWithAssumption(*(task.state->latches), task.frameLevel);
-					std::vector<int> assumption;
+					//bool result = m_mainSolver->SolveWithAssumption(*(task.state->GetLatches()), task.frameLevel);
+					std::vector<int>& assumption = m_assumption;
+					assumption.clear();
 					GetAssumption(task.state, task.frameLevel, assumption);
 					bool result = m_mainSolver->SolveWithAssumption(assumption, task.frameLevel);
 					m_log->StatMainSolver();
+					CheckDecided(*m_mainSolver);
 					if (result)
 					{
 						//Solver return SAT, get a new State, then continue
 						std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > > pair;
 						pair = m_mainSolver->GetAssignment();
 						std::shared_ptr<State> newState(new State (task.state, pair.first, pair.second, task.state->depth+1));
-						m_underSequence.push(newState);
+						newState = m_underSequence.push(newState);
 						int newFrameLevel = GetNewLevel(newState);
 						workingStack.emplace(newState, newFrameLevel, true);
 						continue;
@@ -150,9 +162,8 @@ namespace car
 				startState = EnumerateStartState();
 			}
 			
-			std::vector<std::shared_ptr<std::vector<int> > > lastFrame;
 			frameStep++;
-			m_overSequence->GetFrame(frameStep, lastFrame);
+			FrameView lastFrame = m_overSequence->GetFrame(frameStep);
 			m_mainSolver->AddNewFrame(lastFrame, frameStep);
 			m_overSequence->effectiveLevel++;
 			m_startSovler->UpdateStartSolverFlag();
@@ -173,12 +184,15 @@ namespace car
 	{
 		m_overSequence.reset(new OverSequence(m_model->GetNumInputs()));
 		m_overSequence->isForward = true;
+		//the initial state is the target here, it must not stand in for a state reached from bad
 		m_underSequence = UnderSequence();
-		m_underSequence.push(m_initialState);
-		m_mainSolver.reset(new MainSolver(m_model, true));
-		m_invSolver.reset(new InvSolver(m_model));
-		m_startSovler.reset(new StartSolver(m_model, badId));
+		m_mainSolver = NewMainSolver(m_settings.mainSat, m_model, true, false, 1, m_log->GetTrace("main"));
+		m_invSolver.reset(new InvSolver(m_model, m_settings.invSat, m_log->GetTrace("inv")));
+		m_startSovler.reset(new StartSolver(m_model, badId, m_settings.startSat, m_log->GetTrace("start")));
 		m_log->ResetClock();
+		ApplyLimits(*m_mainSolver);
+		ApplyLimits(m_invSolver->GetSolver());
+		ApplyLimits(m_startSovler->GetSolver());
 	}
 
 	void CleanCARCheckerF::AddUnsatisfiableCore(std::shared_ptr<std::vector<int> > uc, int frameLevel)
@@ -191,47 +205,64 @@ namespace car
 		{
 			m_startSovler->AddClause(-m_startSovler->GetFlag(), *uc);
 		}
-		m_overSequence->Insert(uc, frameLevel);
+		m_overSequence->Insert(*uc, frameLevel);
 		if(frameLevel < m_minUpdateLevel)
 		{
 			m_minUpdateLevel = frameLevel;
 		}
 	}
 
+	void CleanCARCheckerF::ApplyLimits(ISolver& solver)
+	{
+		solver.SetBudget(m_settings.conflictBudget, m_settings.propagationBudget);
+		solver.SetMucBudget(m_settings.mucBudget);
+		if (m_settings.timelimit > 0)
+		{
+			solver.SetDeadline(m_log->GetDeadline());
+		}
+		if (m_settings.worker >= 0 || m_settings.property >= 0)
+		{
+			solver.SetStopFlag(m_log->GetStopFlag());
+		}
+	}
+
+	void CleanCARCheckerF::CheckDecided(ISolver& solver)
+	{
+		if (solver.GetLastResult() == SolveResult::Unknown)
+		{
+			m_log->Timeout();
+		}
+	}
+
 	bool CleanCARCheckerF::ImmediateSatisfiable(int badId)
 	{
-		std::vector<int>& init = *(m_initialState->latches);
+		std::shared_ptr<std::vector<int> > init = m_initialState->GetLatches();
 		std::vector<int> assumptions;
-		assumptions.resize((init.size()));
-		std::copy(init.begin(), init.end(), assumptions.begin());
+		assumptions.resize((init->size()));
+		std::copy(init->begin(), init->end(), assumptions.begin());
 		//assumptions[assumptions.size()-1] = badId;
 		bool result = m_mainSolver->SolveWithAssumptionAndBad(assumptions, badId);
+		CheckDecided(*m_mainSolver);
 		return result;
 	}
 
 	bool CleanCARCheckerF::isInvExisted()
 	{
-		if (m_invSolver == nullptr)
-		{
-			m_invSolver.reset(new InvSolver(m_model));
-		}
-		bool result = false;
 		for (int i = 0; i < m_overSequence->GetLength(); ++i)
 		{
 			if (IsInvariant(i))
 			{
-				result = true;
+				return true;
 			}
 		}
-		m_invSolver = nullptr;
-		return result;
+		return false;
 	}
 
 	int CleanCARCheckerF::GetNewLevel(std::shared_ptr<State> state, int start = 0)
 	{
 		for (int i = start; i < m_overSequence->GetLength(); ++i)
 		{
-			if (!m_overSequence->IsBlockedByFrame(*(state->latches), i))
+			if (!m_overSequence->IsBlockedByFrame(state->latches, i))
 			{
 				return i-1;
 			}
@@ -241,19 +272,24 @@ namespace car
 
 	bool CleanCARCheckerF::IsInvariant(int frameLevel)
 	{
-		std::vector<std::shared_ptr<std::vector<int> > > frame;
-		m_overSequence->GetFrame(frameLevel, frame);
+		FrameView frame = m_overSequence->GetFrame(frameLevel);
 
 		if (frameLevel < m_minUpdateLevel)
 		{
-			m_invSolver->AddConstraintOr(frame);
+			//not updated since the last check, so the solver already has it
+			if (!m_invSolver->IsEncoded(frameLevel))
+			{
+				m_invSolver->UpdateFrame(frame, frameLevel);
+			}
 			return false;
 		}
 
-		m_invSolver->AddConstraintAnd(frame);
- 		bool result = !m_invSolver->SolveWithAssumption();
-		m_invSolver->FlipLastConstrain();
-		m_invSolver->AddConstraintOr(frame);
+		if (m_overSequence->IsSyntacticFixpoint(frameLevel))
+		{
+			return true;
+		}
+		bool result = m_invSolver->IsContained(frame, frameLevel);
+		m_invSolver->UpdateFrame(frame, frameLevel);
 		return result;
 	}
 
@@ -25,6 +25,8 @@ public:
 	CleanCARCheckerF(Settings settings, std::shared_ptr<AigerModel> model);
 
 	bool Run();
+	void Stop() {m_log->Stop();}
+	void ExtendTimelimit(double seconds) {m_log->ExtendTimelimit(seconds);}
 
 	bool Check(int badId);
 
@@ -33,6 +35,12 @@ private:
 
 	void AddUnsatisfiableCore(std::shared_ptr<std::vector<int> > uc, int frameLevel);
 
+	//the query budgets and the deadline of the check, for a new solver
+	void ApplyLimits(ISolver& solver);
+
+	//a query that gave up leaves no sound way on, so the check ends as a timeout
+	void CheckDecided(ISolver& solver);
+
 	bool ImmediateSatisfiable(int badId);
 
 	bool isInvExisted();
@@ -44,15 +52,17 @@ private:
 	
 	void GetAssumption(std::shared_ptr<State> state, int frameLevel, std::vector<int>& ass)
 	{
-		ass.reserve(state->latches->size());
-		ass.insert(ass.begin(), state->latches->begin(), state->latches->end());
+		ass.reserve(ass.size() + State::numLatches);
+		state->AppendLatches(ass);
 		for(auto& x:ass)
 			x = m_model->GetPrime(x);
 	}
 
 	
 	std::shared_ptr<State> EnumerateStartState(){
-		if (m_startSovler->SolveWithAssumption()){
+		bool result = m_startSovler->SolveWithAssumption();
+		CheckDecided(m_startSovler->GetSolver());
+		if (result){
 				return m_startSovler->GetStartState();
 		}	else{
 				return nullptr;
@@ -68,7 +78,8 @@ private:
 	std::shared_ptr<AigerModel> m_model;
 	std::shared_ptr<State> m_initialState;
 	std::shared_ptr<ISolver> m_mainSolver;
-	std::shared_ptr<ISolver> m_invSolver;
+	std::shared_ptr<InvSolver> m_invSolver;
+	std::vector<int> m_assumption;//refilled by GetAssumption for every query, so its storage is reused
   std::shared_ptr<StartSolver> m_startSovler;
 	std::vector<std::shared_ptr<std::vector<int> > > m_rotation;
 };
@@ -1,15 +1,12 @@
 #include "ForwardChecker.h"
 #include <stack>
 #include <string>
-#include "hash_set.h"
 
 namespace car
 {
 	ForwardChecker::ForwardChecker(Settings settings, std::shared_ptr<AigerModel> model) : m_settings(settings)
 	{
 		m_model = model;
-		State::numInputs = model->GetNumInputs();
-		State::numLatches = model->GetNumLatches(); 
 		m_log.reset(new Log(settings, model));
 
 		const std::vector<int>& init = model->GetInitialState();
@@ -26,8 +23,21 @@ namespace car
 
 	bool ForwardChecker::Run()
 	{
+		if (m_settings.reuseFrames)
+		{
+			//the frames go on from one property to the next, so one cone has to cover them all
+			m_model->SetCone(m_model->GetOutputs());
+			if (m_settings.simplify)
+			{
+				m_model->Simplify();
+			}
+		}
 		for (int i = 0, maxI = m_model->GetOutputs().size(); i < maxI; ++i)
 		{
+			if (m_settings.property >= 0 && i != m_settings.property)
+			{
+				continue;
+			}
 			int badId = m_model->GetOutputs().at(i);
 			setCurrentBad(badId);
 			bool result = Check(badId);
@@ -43,6 +53,11 @@ namespace car
 			if (m_settings.Visualization) {
 				m_vis->OutputGML(false);
 			} 
+			m_log->PrintSth("repeated states num: " + std::to_string(m_underSequence.GetRepeats()));
+			if (m_settings.dead)
+			{
+				m_log->PrintSth("dead states num: " + std::to_string(m_deadStates));
+			}
 			m_log->PrintStatistics();
 		}
 		return true;
@@ -51,15 +66,22 @@ namespace car
 	bool ForwardChecker::Check(int badId)
 	{
 #pragma region early stage
-		if (m_model->GetTrueId() == badId)
+		//a bad that is constant true still goes through the queries below, 
+		//as the constraints may hold in no initial state
+		if (m_model->GetFalseId() == badId)
 		{
 			//placeholder
-			return false;
+			return true;
 		}
-		else if (m_model->GetFalseId() == badId)
+
+		//only the cone of bad is encoded, and the states only keep its latches
+		if (!m_settings.reuseFrames)
 		{
-			//placeholder
-			return true;
+			m_model->SetCone(badId);
+			if (m_settings.simplify)
+			{
+				m_model->Simplify();
+			}
 		}
 
  		Init(badId);
@@ -71,27 +93,35 @@ namespace car
 #else
 			auto pair = m_mainSolver->GetAssignment();
 #endif
+			//bad in the initial state, under these inputs
+			m_initialState->preState = nullptr;
 			m_initialState->inputs = pair.first;
+			m_log->lastState = m_initialState;
 			return false;
 		}
 
-		for(auto latch:*(m_initialState->latches))
+		if (m_solverLevel < 0)
 		{
-			std::shared_ptr<std::vector<int> > puc(new std::vector<int> {-latch});
-			m_overSequence->Insert(puc, 0);
-			
-		}
+			std::shared_ptr<std::vector<int> > initLatches = m_initialState->GetLatches();
+			for(auto latch:*initLatches)
+			{
+				std::shared_ptr<std::vector<int> > puc(new std::vector<int> {-latch});
+				m_overSequence->Insert(*puc, 0);
+				
+			}
 
 #ifdef __DEBUG__
-		m_log->PrintUcNums(uc, m_overSequence);
+			m_log->PrintUcNums(uc, m_overSequence);
 #endif
 
 
-		std::vector<std::shared_ptr<std::vector<int> > > frame;
-		m_overSequence->GetFrame(0, frame);
-		m_mainSolver->AddNewFrame(frame, 0);
+			FrameView frame = m_overSequence->GetFrame(0);
+			m_mainSolver->AddNewFrame(frame, 0);
+			m_solverLevel = 0;
+		}
 		m_overSequence->effectiveLevel = 0;
 		m_startSovler->UpdateStartSolverFlag();
+		AddFrontierToStartSolver();
 # pragma endregion 
 
 		//main stage
@@ -141,13 +171,44 @@ namespace car
 					m_log->Tick();
 					if(m_settings.debug)
 					{	
-						m_log->PrintSAT(*(task.state->latches), task.frameLevel);
+						m_log->PrintSAT(*(task.state->GetLatches()), task.frameLevel);
 					}
-					//bool result = m_mainSolver->SolveWithAssumption(*(task.state->latches), task.frameLevel);
-					std::vector<int> assumption;
+					//bool result = m_mainSolver->SolveWithAssumption(*(task.state->GetLatches()), task.frameLevel);
+					std::vector<int>& assumption = m_assumption;
+					assumption.clear();
 					GetAssumption(task.state, task.frameLevel, assumption);
-					bool result = m_mainSolver->SolveWithAssumption(assumption, task.frameLevel);
+					bool result;
+					if (m_settings.unroll > 1)
+					{
+						//look k steps back first, the lemma still comes from the one-step query below
+						result = m_mainSolver->SolveWithAssumptionUnroll(assumption, task.frameLevel);
+						m_log->StatMainSolver();
+						if (result)
+						{
+							std::shared_ptr<State> succState = task.state;
+							auto steps = m_mainSolver->GetUnrollAssignment();
+							for (auto& pair : steps)
+							{
+								if (m_settings.partial)
+								{
+									GetPartialState(pair, succState);
+								}
+								std::shared_ptr<State> newState(new State (succState, pair.first, pair.second, succState->depth+1));
+								std::shared_ptr<State> pushed = m_underSequence.push(newState);
+								if (m_settings.Visualization && pushed == newState) {
+									m_vis->addState(newState);
+								}
+								succState = pushed;
+							}
+							int newFrameLevel = GetNewLevel(succState);
+							workingStack.emplace(succState, newFrameLevel, true);
+							continue;
+						}
+						m_log->Tick();
+					}
+					result = m_mainSolver->SolveWithAssumption(assumption, task.frameLevel);
 					m_log->StatMainSolver();
+					CheckDecided(*m_mainSolver);
 					if (result)
 					{
 						//Solver return SAT, get a new State, then continue
@@ -167,10 +228,12 @@ namespace car
 						}
 
 						std::shared_ptr<State> newState(new State (task.state, pair.first, pair.second, task.state->depth+1));
-						m_underSequence.push(newState);
-						if (m_settings.Visualization) {
+						//a state reached again goes on as the one reached first
+						std::shared_ptr<State> pushed = m_underSequence.push(newState);
+						if (m_settings.Visualization && pushed == newState) {
 							m_vis->addState(newState);
-						}  
+						}
+						newState = pushed;
 						int newFrameLevel = GetNewLevel(newState);
 						workingStack.emplace(newState, newFrameLevel, true);
 						continue;
@@ -188,7 +251,7 @@ namespace car
 							//placeholder, uc is empty => safe
 						}
 						m_log->Tick();
-						removeWrongElementsFromUc(uc,task.state,m_settings.partial);
+						removeWrongElementsFromUc(uc,task.state);
 						AddUnsatisfiableCore(uc, task.frameLevel+1);
 						if (m_settings.debug)
 						{
@@ -211,12 +274,21 @@ namespace car
 			{
 				Propagation();
 			}
-			std::vector<std::shared_ptr<std::vector<int> > > lastFrame;
 			frameStep++;
-			m_overSequence->GetFrame(frameStep, lastFrame);
-			m_mainSolver->AddNewFrame(lastFrame, frameStep);
+			if (frameStep > m_solverLevel)
+			{
+				FrameView lastFrame = m_overSequence->GetFrame(frameStep);
+				m_mainSolver->AddNewFrame(lastFrame, frameStep);
+				m_solverLevel = frameStep;
+			}
 			m_overSequence->effectiveLevel++;
 			m_startSovler->UpdateStartSolverFlag();
+			AddFrontierToStartSolver();
+			//the start solver has them already
+			for (auto& uc : m_deadUcs)
+			{
+				AddDeadCore(uc, m_overSequence->effectiveLevel + 1);
+			}
 			
 
 			m_log->Tick();
@@ -233,39 +305,67 @@ namespace car
 
 	void ForwardChecker::Init(int badId)
 	{
-		if (m_settings.propagation)
+		if (m_settings.reuseFrames && m_overSequence != nullptr)
 		{
-			m_overSequence.reset(new OverSequenceForProp(m_model->GetNumInputs()));
+			//the frames over-approximate the states reachable from init whatever bad is, so they and the solvers 
+			//that hold them go on. bad is cleared from every frame again before one is taken as an invariant
+			m_initialState->preState = nullptr;
 		}
 		else
 		{
-			m_overSequence.reset(new OverSequence(m_model->GetNumInputs()));
+			if (m_settings.propagation)
+			{
+				m_overSequence.reset(new OverSequenceForProp(m_model->GetNumInputs()));
+			}
+			else
+			{
+				m_overSequence.reset(new OverSequence(m_model->GetNumInputs()));
+			}
+			m_mainSolver = NewMainSolver(m_settings.mainSat, m_model, true, m_settings.muc, m_settings.unroll, m_log->GetTrace("main"));
+			m_partialSolver = NewMainSolver(m_settings.partialSat, m_model, true, m_settings.muc, 1, m_log->GetTrace("partial"));
+			m_invSolver.reset(new InvSolver(m_model, m_settings.invSat, m_log->GetTrace("inv")));
+			m_solverLevel = -1;
+			if (m_settings.dead)
+			{
+				m_deadSolver = NewMainSolver(m_settings.mainSat, m_model, true, m_settings.muc, 1, m_log->GetTrace("dead"));
+				ApplyLimits(*m_deadSolver);
+			}
+			m_deadUcs.clear();
 		}
+		m_deadStates = 0;
+		m_invCheckedLevel = -1;
 		if (m_settings.Visualization) {
 			m_vis.reset(new Vis(m_settings, m_model));
 			m_vis->addState(m_initialState);
 		}
 		m_overSequence->isForward = true;
+		//the initial state is the target here, it must not stand in for a state reached from bad
 		m_underSequence = UnderSequence();
-		m_underSequence.push(m_initialState);
-		m_mainSolver.reset(new MainSolver(m_model, true, m_settings.muc));
-		m_partialSolver.reset(new MainSolver(m_model, true, m_settings.muc));
-		m_invSolver.reset(new InvSolver(m_model));
-		m_startSovler.reset(new StartSolver(m_model, badId));
+		//the cubes of another property range over the latches of its cone
+		m_rotation.clear();
+		m_startSovler.reset(new StartSolver(m_model, badId, m_settings.startSat, m_log->GetTrace("start")));
 		m_log->ResetClock();
+		ApplyLimits(*m_mainSolver);
+		ApplyLimits(*m_partialSolver);
+		ApplyLimits(m_invSolver->GetSolver());
+		ApplyLimits(m_startSovler->GetSolver());
+		for (auto& uc : m_deadUcs)
+		{
+			m_startSovler->AddPermanentClause(uc);
+		}
 	}
 
 	void ForwardChecker::AddUnsatisfiableCore(std::shared_ptr<std::vector<int> > uc, int frameLevel)
 	{
-		if (frameLevel <= m_overSequence->effectiveLevel)
+		if (frameLevel <= m_solverLevel)
 		{
 			m_mainSolver->AddUnsatisfiableCore(*uc, frameLevel);
 		}
-		else
+		if (frameLevel == m_overSequence->effectiveLevel + 1)
 		{
 			m_startSovler->AddClause(-m_startSovler->GetFlag(), *uc);
 		}
-		m_overSequence->Insert(uc, frameLevel);
+		m_overSequence->Insert(*uc, frameLevel);
 		if(frameLevel < m_minUpdateLevel)
 		{
 			m_minUpdateLevel = frameLevel;
@@ -285,7 +385,7 @@ namespace car
 		assumptions.insert(predecessorAssignment.second->begin(),predecessorAssignment.second->end(),assumptions.end());
 		if (successorState != nullptr)
 		{
-			std::vector<int> successorLatches = *(successorState->latches);
+			std::vector<int> successorLatches = *(successorState->GetLatches());
 			for(auto& literal: successorLatches)
 			{
 				literal = - m_model->GetPrime(literal);
@@ -296,12 +396,14 @@ namespace car
 			assumptions.push_back(-flag);
 
 			bool result = m_partialSolver->SolveWithAssumption ();
+			CheckDecided(*m_partialSolver);
 		
 			assert (!result);
 			std::shared_ptr<std::vector<int> > partialUc(new std::vector<int>());
 			partialUc = m_partialSolver->GetParialStateUnsatisfiableCore();
 			if (partialUc->empty()){
-				partialUc->assign(m_initialState->latches->begin(),m_initialState->latches->end());
+				std::shared_ptr<std::vector<int> > init = m_initialState->GetLatches();
+				partialUc->assign(init->begin(),init->end());
 			}
 			predecessorAssignment.second->clear();
 			predecessorAssignment.second->insert(partialUc->begin(),partialUc->end(),predecessorAssignment.second->begin());
@@ -314,6 +416,7 @@ namespace car
 			int bad = getCurrentBad();
 			assumptions.push_back (-bad);
 			bool result = m_partialSolver->SolveWithAssumption ();
+			CheckDecided(*m_partialSolver);
 			assert (!result);
 			std::shared_ptr<std::vector<int> > partialUc(new std::vector<int>());
 			partialUc = m_partialSolver->GetParialStateUnsatisfiableCore();
@@ -330,81 +433,166 @@ namespace car
 		}
 	}
 
-	void ForwardChecker::removeWrongElementsFromUc(std::shared_ptr<std::vector<int> > uc,std::shared_ptr<State> state,bool isPartial)
+	void ForwardChecker::removeWrongElementsFromUc(std::shared_ptr<std::vector<int> > uc,std::shared_ptr<State> state)
 	{
-		std::shared_ptr<std::vector<int> > tempUc;
-		if (!isPartial){
-			int latchStart = m_model->GetNumInputs()+1;
-			for(auto it : *(uc)){
-				if (state->latches->at(abs(it)-latchStart) == it)
-					tempUc->push_back (it);
-			}
+		std::shared_ptr<std::vector<int> > tempUc(new std::vector<int>());
+		for (auto it : *(uc))
+		{
+			if (state->HasLiteral(it))
+				tempUc->push_back (it);
 		}
-		else{
-			hash_set<int> tempSet;
-			for (auto it : *(state->latches))
-				tempSet.insert (it);
-			for (auto it : *(uc)){
-				if (tempSet.find (it) != tempSet.end())
-					tempUc->push_back (it);
+		uc->swap(*tempUc);
+	}
+
+	void ForwardChecker::ApplyLimits(ISolver& solver)
+	{
+		solver.SetBudget(m_settings.conflictBudget, m_settings.propagationBudget);
+		solver.SetMucBudget(m_settings.mucBudget);
+		if (m_settings.timelimit > 0)
+		{
+			solver.SetDeadline(m_log->GetDeadline());
+		}
+		if (m_settings.worker >= 0 || m_settings.property >= 0)
+		{
+			solver.SetStopFlag(m_log->GetStopFlag());
+		}
+	}
+
+	void ForwardChecker::CheckDecided(ISolver& solver)
+	{
+		if (solver.GetLastResult() == SolveResult::Unknown)
+		{
+			if (m_settings.Visualization) {
+				m_vis->OutputGML(true);
 			}
+			m_log->Timeout();
 		}
-		uc = tempUc;
 	}
 
 	bool ForwardChecker::ImmediateSatisfiable(int badId)
 	{
-		std::vector<int>& init = *(m_initialState->latches);
+		std::shared_ptr<std::vector<int> > init = m_initialState->GetLatches();
 		std::vector<int> assumptions;
-		assumptions.resize((init.size()));
-		std::copy(init.begin(), init.end(), assumptions.begin());
+		assumptions.resize((init->size()));
+		std::copy(init->begin(), init->end(), assumptions.begin());
 		//assumptions[assumptions.size()-1] = badId;
 		bool result = m_mainSolver->SolveWithAssumptionAndBad(assumptions, badId);
+		CheckDecided(*m_mainSolver);
 		return result;
 	}
 
 	std::shared_ptr<State> ForwardChecker::EnumerateStartState()
     {
-        if (m_startSovler->SolveWithAssumption())
+        while (true)
         {
+	        bool result = m_startSovler->SolveWithAssumption();
+	        CheckDecided(m_startSovler->GetSolver());
+	        if (!result)
+	        {
+	            return nullptr;
+	        }
 			std::shared_ptr<State> badState = m_startSovler->GetStartState();
 			if (m_settings.partial)
 			{
-				inputLatchPair badPair(badState->inputs,badState->latches);
+				inputLatchPair badPair(m_startSovler->GetStartInputs(),badState->GetLatches());
 				GetPartialState(badPair,nullptr);
 			}
+			if (m_settings.dead && IsDead(badState))
+			{
+				if (m_deadUcs.back().empty())
+				{
+					//no state has a predecessor, the frames after the initial one are empty now
+					return nullptr;
+				}
+				continue;
+			}
             return badState;
         }
-        else
-        {
-            return nullptr;
-        }
     }
 
+	bool ForwardChecker::IsDead(std::shared_ptr<State> state)
+	{
+		m_log->Tick();
+		std::vector<int>& assumption = m_assumption;
+		assumption.clear();
+		state->AppendLatches(assumption);
+		for (auto& latch : assumption)
+		{
+			latch = m_model->GetPrime(latch);
+		}
+		//the solver has no frame, the flag of level 0 is free
+		bool result = m_deadSolver->SolveWithAssumption(assumption, 0);
+		m_log->StatMainSolver();
+		CheckDecided(*m_deadSolver);
+		if (result)
+		{
+			return false;
+		}
+		auto uc = m_deadSolver->GetUnsatisfiableCore();
+		removeWrongElementsFromUc(uc, state);
+		m_deadStates++;
+		m_deadUcs.push_back(*uc);
+		if (!uc->empty())
+		{
+			m_startSovler->AddPermanentClause(*uc);
+		}
+		//no state is reached in the cube after the first step, the initial states are not touched
+		for (int i = 1; i <= m_overSequence->effectiveLevel + 1 || i < m_overSequence->GetLength(); ++i)
+		{
+			AddDeadCore(*uc, i);
+		}
+		return true;
+	}
 
-	bool ForwardChecker::isInvExisted()
+	void ForwardChecker::AddDeadCore(const std::vector<int>& uc, int frameLevel)
 	{
-		if (m_invSolver == nullptr)
+		if (frameLevel <= m_solverLevel)
 		{
-			m_invSolver.reset(new InvSolver(m_model));
+			m_mainSolver->AddUnsatisfiableCore(uc, frameLevel);
 		}
-		bool result = false;
-		for (int i = 0; i < m_overSequence->GetLength(); ++i)
+		m_overSequence->Insert(uc, frameLevel);
+		if (frameLevel < m_minUpdateLevel)
 		{
-			if (IsInvariant(i))
+			m_minUpdateLevel = frameLevel;
+		}
+	}
+
+
+	bool ForwardChecker::isInvExisted()
+	{
+		//a frame kept from another property beyond the effective ones may still hold bad states
+		for (int i = 0, end = std::min(m_overSequence->GetLength(), m_overSequence->effectiveLevel + 1); i < end; ++i)
+		{
+			bool result = IsInvariant(i);
+			m_invCheckedLevel = std::max(m_invCheckedLevel, i);
+			if (result)
 			{
-				result = true;
+				return true;
 			}
 		}
-		m_invSolver = nullptr;
-		return result;
+		return false;
+	}
+
+	void ForwardChecker::AddFrontierToStartSolver()
+	{
+		int level = m_overSequence->effectiveLevel + 1;
+		if (level >= m_overSequence->GetLength())
+		{
+			return;
+		}
+		FrameView frame = m_overSequence->GetFrame(level);
+		for (int i = 0; i < frame.size(); ++i)
+		{
+			std::vector<int> uc(frame[i].begin(), frame[i].end());
+			m_startSovler->AddClause(-m_startSovler->GetFlag(), uc);
+		}
 	}
 
 	int ForwardChecker::GetNewLevel(std::shared_ptr<State> state, int start = 0)
 	{
 		for (int i = start; i < m_overSequence->GetLength(); ++i)
 		{
-			if (!m_overSequence->IsBlockedByFrame(*(state->latches), i, m_settings.partial))
+			if (!m_overSequence->IsBlockedByFrame(state->latches, i))
 			{
 				return i-1;
 			}
@@ -414,19 +602,24 @@ namespace car
 
 	bool ForwardChecker::IsInvariant(int frameLevel)
 	{
-		std::vector<std::shared_ptr<std::vector<int> > > frame;
-		m_overSequence->GetFrame(frameLevel, frame);
+		FrameView frame = m_overSequence->GetFrame(frameLevel);
 
-		if (frameLevel < m_minUpdateLevel)
+		if (frameLevel < m_minUpdateLevel && frameLevel <= m_invCheckedLevel)
 		{
-			m_invSolver->AddConstraintOr(frame);
+			//not updated since the last check, so the solver already has it
+			if (!m_invSolver->IsEncoded(frameLevel))
+			{
+				m_invSolver->UpdateFrame(frame, frameLevel);
+			}
 			return false;
 		}
 
-		m_invSolver->AddConstraintAnd(frame);
- 		bool result = !m_invSolver->SolveWithAssumption();
-		m_invSolver->FlipLastConstrain();
-		m_invSolver->AddConstraintOr(frame);
+		if (m_overSequence->IsSyntacticFixpoint(frameLevel))
+		{
+			return true;
+		}
+		bool result = m_invSolver->IsContained(frame, frameLevel);
+		m_invSolver->UpdateFrame(frame, frameLevel);
 		return result;
 	}
 
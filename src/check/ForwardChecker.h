@@ -25,12 +25,20 @@ class ForwardChecker : public BaseChecker
 public:
 	ForwardChecker(Settings settings, std::shared_ptr<AigerModel> model);
 	bool Run();
+	void Stop() {m_log->Stop();}
+	void ExtendTimelimit(double seconds) {m_log->ExtendTimelimit(seconds);}
 	bool Check(int badId);
 private:
 	void Init(int badId);
 
 	void AddUnsatisfiableCore(std::shared_ptr<std::vector<int> > uc, int frameLevel);
 
+	//the query budgets and the deadline of the check, for a new solver
+	void ApplyLimits(ISolver& solver);
+
+	//a query that gave up leaves no sound way on, so the check ends as a timeout
+	void CheckDecided(ISolver& solver);
+
 	bool ImmediateSatisfiable(int badId);
 
 	bool isInvExisted();
@@ -39,32 +47,41 @@ private:
 
 	int GetNewLevel(std::shared_ptr<State> state, int start = 0);
 
+	//with -dead, a start state without predecessors is blocked for good and the next one is taken
 	std::shared_ptr<State> EnumerateStartState();
 
+	//whether no state at all goes to the state under T and the constraints. 
+	//if so, the uc of the query is a dead cube: it is added to the start solver and to every frame but the initial one
+	bool IsDead(std::shared_ptr<State> state);
+
+	void AddDeadCore(const std::vector<int>& uc, int frameLevel);
+
+	//the start states are bad states in the frame after the effective ones. when that frame is kept 
+	//from an earlier property, its ucs go to the start solver under the new flag
+	void AddFrontierToStartSolver();
+
 	void GetPartialState ( inputLatchPair predecessorAssignment, std::shared_ptr<State> successorState = nullptr);
 
-	void removeWrongElementsFromUc(std::shared_ptr<std::vector<int> > uc,std::shared_ptr<State> state,bool isPartial);
+	void removeWrongElementsFromUc(std::shared_ptr<std::vector<int> > uc,std::shared_ptr<State> state);
 
-	void GetPriority (std::shared_ptr<std::vector<int> > latches, const int frameLevel, std::vector<int>& res) 
+	void GetPriority (std::shared_ptr<State> state, const int frameLevel, std::vector<int>& res) 
 	{    
 		if (frameLevel+1 >= m_overSequence->GetLength())
 		{
 			return;
 		}
-	    std::vector<std::shared_ptr<std::vector<int> > > frame;
-		m_overSequence->GetFrame(frameLevel+1, frame);
-	    if (frame.size () == 0)  
+	    if (m_overSequence->GetFrameSize(frameLevel+1) == 0)  
 		{
 	    	return;
 		}
 	    	
-	    std::shared_ptr<std::vector<int> > uc = frame[frame.size()-1];
-	    res.reserve (uc->size());
-	    for (int i = 0; i < uc->size() ; ++ i) 
+	    Lemma uc = m_overSequence->GetFrame(frameLevel+1).back();
+	    res.reserve (uc.size());
+	    for (int i = 0; i < uc.size() ; ++ i) 
 		{
-	    	if ((*latches)[abs((*uc)[i])-m_model->GetNumInputs()-1] == (*uc)[i]) 
+	    	if (state->HasLiteral(uc[i])) 
 			{
-	    		res.push_back ((*uc)[i]);
+	    		res.push_back (uc[i]);
 	    	}
 	    }
 	}
@@ -74,38 +91,27 @@ private:
 	{
 		if (m_settings.inter)
 		{
-			GetPriority(state->latches, frameLevel, ass);
+			GetPriority(state, frameLevel, ass);
 		}
 
-		ass.reserve(ass.size() + state->latches->size());
+		ass.reserve(ass.size() + State::numLatches);
 
-		if (m_settings.rotate)
+		if (m_settings.rotate && frameLevel + 2 <= m_rotation.size() && m_rotation[frameLevel+1] != nullptr)
 		{
-			std::vector<int> tmp;
-			tmp.reserve (state->latches->size());
-			int aa = m_rotation.size();
-			if (frameLevel + 2 > m_rotation.size()) 
-			{
-				ass.insert(ass.end(), state->latches->begin(), state->latches->end());
-				return;
-			}
-			else if (m_rotation[frameLevel+1] == nullptr)
-			{
-				ass.insert(ass.end(), state->latches->begin(), state->latches->end());
-				return;
-			}
+			//the literals the state shares with the cube first, then the ones it flips
 			std::vector<int>& cube = *m_rotation[frameLevel+1];
 			for (int i = 0; i < cube.size (); ++ i) {
-				if ((*state->latches)[abs(cube[i])-m_model->GetNumInputs()-1] == cube[i]) 
+				if (state->HasLiteral(cube[i])) 
 					ass.push_back (cube[i]);
-				else
-					tmp.push_back (-cube[i]);
 			}
-			ass.insert(ass.end(), tmp.begin(), tmp.end());
+			for (int i = 0; i < cube.size (); ++ i) {
+				if (!state->HasLiteral(cube[i])) 
+					ass.push_back (-cube[i]);
+			}
 		}
 		else
 		{
-			ass.insert(ass.end(), state->latches->begin(), state->latches->end());
+			state->AppendLatches(ass);
 		}
         
         for(auto& x:ass)
@@ -120,7 +126,7 @@ private:
 		{
 			m_rotation.push_back(nullptr);
 		}
-		m_rotation[frameLevel+1] = state->latches;
+		m_rotation[frameLevel+1] = state->GetLatches();
 	}
 
 	void Propagation()
@@ -128,22 +134,28 @@ private:
 		OverSequenceForProp* sequence = dynamic_cast<OverSequenceForProp*>(m_overSequence.get());
 		for (int frameLevel = 0; frameLevel < sequence->GetLength()-1; ++frameLevel)
 		{
-			std::vector<std::shared_ptr<std::vector<int> > > unpropFrame = sequence->GetUnProp(frameLevel);
-			std::vector<std::shared_ptr<std::vector<int> > > propFrame = sequence->GetProp(frameLevel);
+			//inserting below modifies the frames, so take the ucs out of the arena first
+			FrameView unprop = sequence->GetUnProp(frameLevel);
+			std::vector<std::shared_ptr<std::vector<int> > > unpropFrame;
+			unpropFrame.reserve(unprop.size());
+			for (int j = 0; j < unprop.size(); ++j)
+			{
+				unpropFrame.push_back(unprop[j].ToVector());
+			}
 			std::vector<std::shared_ptr<std::vector<int> > > tmp;
 			for (int j = 0; j < unpropFrame.size(); ++j)
 			{	
-				if (sequence->IsBlockedByFrame(*unpropFrame[j], frameLevel+1))
+				if (sequence->IsBlockedByFrame(PackedState(*unpropFrame[j], m_model->GetNumInputs(), m_model->GetNumLatches()), frameLevel+1))
 				{
-					propFrame.push_back(unpropFrame[j]);
 					continue;
 				}
 
 				bool result = m_mainSolver->SolveWithAssumption(*unpropFrame[j], frameLevel);
-				if (!result)
+				//a query that gave up leaves the lemma unpropagated
+				if (!result && m_mainSolver->GetLastResult() == SolveResult::Unsat)
 				{
 					AddUnsatisfiableCore(unpropFrame[j], frameLevel+1);
-					sequence->InsertIntoProped(unpropFrame[j], frameLevel);
+					sequence->InsertIntoProped(*unpropFrame[j], frameLevel);
 				}
 				else
 				{
@@ -160,6 +172,10 @@ private:
 	int getCurrentBad () {return currentBad;}
 
 	int m_minUpdateLevel;
+	//the last frame the main solver holds, above the effective ones when the frames are kept across properties
+	int m_solverLevel = -1;
+	//the last frame checked for an invariant in this check, a frame kept from before is checked in full once
+	int m_invCheckedLevel = -1;
 	int currentBad;
 	std::shared_ptr<IOverSequence> m_overSequence;
 	//IOverSequence* m_overSequence;
@@ -171,7 +187,11 @@ private:
 	std::shared_ptr<State> m_initialState;
 	std::shared_ptr<ISolver> m_mainSolver;
 	std::shared_ptr<ISolver> m_partialSolver;
-	std::shared_ptr<ISolver> m_invSolver;
+	std::shared_ptr<InvSolver> m_invSolver;
+	std::shared_ptr<ISolver> m_deadSolver;//T without frames, for -dead
+	std::vector<std::vector<int> > m_deadUcs;//they hold while the cone stays the same
+	int m_deadStates = 0;
+	std::vector<int> m_assumption;//refilled by GetAssumption for every query, so its storage is reused
     std::shared_ptr<StartSolver> m_startSovler;
 	std::vector<std::shared_ptr<std::vector<int> > > m_rotation;
 };
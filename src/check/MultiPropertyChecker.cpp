@@ -0,0 +1,176 @@
+#include "MultiPropertyChecker.h"
+#include "BackwardChecker.h"
+#include "ForwardChecker.h"
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <algorithm>
+
+namespace car
+{
+	MultiPropertyChecker::MultiPropertyChecker(Settings settings, std::shared_ptr<AigerModel> model): m_stopped(false)
+	{
+		m_settings = settings;
+		m_model = model;
+		m_log.reset(new Log(settings, model));
+		m_numProperties = model->GetOutputs().size();
+		m_numUndecided = m_numProperties;
+	}
+
+	bool MultiPropertyChecker::Run()
+	{
+		m_begin = std::chrono::steady_clock::now();
+		int numThreads = std::min(m_settings.jobs, m_numProperties);
+		m_running.resize(numThreads);
+		m_deadlines.resize(numThreads);
+		std::vector<std::thread> threads;
+		for (int i = 0; i < numThreads; ++i)
+		{
+			threads.emplace_back(&MultiPropertyChecker::Work, this, i);
+		}
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+		//the ones a stop left waiting
+		for (; m_nextProperty < m_numProperties; ++m_nextProperty)
+		{
+			m_log->PrintUnknown(m_nextProperty);
+		}
+		return true;
+	}
+
+	void MultiPropertyChecker::Stop()
+	{
+		m_stopped = true;
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (auto& checker : m_running)
+		{
+			if (checker != nullptr)
+			{
+				checker->Stop();
+			}
+		}
+	}
+
+	void MultiPropertyChecker::Work(int thread)
+	{
+		while (!m_stopped)
+		{
+			Settings settings = m_settings;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (m_nextProperty == m_numProperties)
+				{
+					return;
+				}
+				settings.property = m_nextProperty++;
+				settings.timelimit = GetBudget();
+				if (settings.timelimit < 0)
+				{
+					Collect(settings.property, false);
+					continue;
+				}
+				m_deadlines[thread] = std::chrono::steady_clock::now() + std::chrono::seconds(settings.timelimit);
+			}
+			settings.Visualization = false;
+			//shares the clauses of T with m_model, the cone it is restricted to is its own
+			std::shared_ptr<AigerModel> model(new AigerModel(*m_model));
+			std::shared_ptr<BaseChecker> checker;
+			if (settings.forward)
+			{
+				checker.reset(new ForwardChecker(settings, model));
+			}
+			else
+			{
+				checker.reset(new BackwardChecker(settings, model));
+			}
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_running[thread] = checker;
+				//a stop while it was built missed it
+				if (m_stopped)
+				{
+					checker->Stop();
+				}
+			}
+			bool isDecided = false;
+			try
+			{
+				checker->Run();
+				isDecided = true;
+			}
+			catch (const CheckStopped&)
+			{
+				//out of its budget
+			}
+			std::lock_guard<std::mutex> lock(m_mutex);
+			//closes the files of the check
+			m_running[thread] = nullptr;
+			checker = nullptr;
+			Collect(settings.property, isDecided);
+			ExtendRunning();
+		}
+	}
+
+	int MultiPropertyChecker::GetBudget()
+	{
+		if (m_settings.timelimit <= 0)
+		{
+			return 0;
+		}
+		double left = m_settings.timelimit - std::chrono::duration<double>(std::chrono::steady_clock::now() - m_begin).count();
+		if (left < 1)
+		{
+			return -1;
+		}
+		//the properties not decided yet share the time left, jobs of them at a time
+		double share = left * std::min(m_settings.jobs, m_numUndecided) / m_numUndecided;
+		return std::max(1, (int)(share + 0.5));
+	}
+
+	void MultiPropertyChecker::ExtendRunning()
+	{
+		int budget = GetBudget();
+		if (budget <= 0)
+		{
+			return;
+		}
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(budget);
+		for (int i = 0; i < m_running.size(); ++i)
+		{
+			if (m_running[i] != nullptr && deadline > m_deadlines[i])
+			{
+				m_running[i]->ExtendTimelimit(std::chrono::duration<double>(deadline - m_deadlines[i]).count());
+				m_deadlines[i] = deadline;
+			}
+		}
+	}
+
+	void MultiPropertyChecker::Collect(int property, bool isDecided)
+	{
+		--m_numUndecided;
+		Settings settings = m_settings;
+		settings.property = property;
+		std::string outPath = Log::GetOutPath(settings);
+		if (isDecided)
+		{
+			std::ifstream res(outPath + ".res");
+			m_log->m_res << res.rdbuf();
+		}
+		else
+		{
+			m_log->PrintUnknown(property);
+		}
+		m_log->m_res.flush();
+		std::ifstream in(outPath + ".log");
+		std::stringstream log;
+		log << in.rdbuf();
+		m_log->PrintSth("property " + std::to_string(property) + (isDecided ? "" : ": time out!!!"));
+		m_log->PrintSth(log.str());
+		std::remove((outPath + ".res").c_str());
+		std::remove((outPath + ".log").c_str());
+	}
+
+}//namespace car
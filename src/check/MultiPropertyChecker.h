@@ -0,0 +1,57 @@
+#ifndef MULTIPROPERTYCHECKER_H
+#define MULTIPROPERTYCHECKER_H
+
+#include "BaseChecker.h"
+#include "Log.h"
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+namespace car
+{
+
+///
+//checks the properties of a model on a pool of threads, each one by a checker of its own over a copy of the model
+//that shares the clauses of T with the others and restricts them to its own cone.
+//a property starts with its share of the time left, so the time an easy property does not use goes to the ones after it,
+//and the ones still running get more time when it finishes. a result is written as soon as it is known,
+//so the results come in the order the properties are decided; a property out of time is written as unknown
+///
+class MultiPropertyChecker : public BaseChecker
+{
+public:
+	MultiPropertyChecker(Settings settings, std::shared_ptr<AigerModel> model);
+	bool Run();
+	void Stop();
+private:
+	void Work(int thread);
+
+	//the seconds the next property may take, 0 for no limit and -1 if no time is left. called with m_mutex held
+	int GetBudget();
+
+	//moves the deadline of each running property to where the budget of a property starting now would end, 
+	//if that is later. called with m_mutex held
+	void ExtendRunning();
+
+	//appends the result and the log of a check to those of the run and removes its files. called with m_mutex held
+	void Collect(int property, bool isDecided);
+
+	Settings m_settings;
+	std::shared_ptr<AigerModel> m_model;
+	std::shared_ptr<Log> m_log;
+	std::chrono::steady_clock::time_point m_begin;
+	std::atomic<bool> m_stopped;
+
+	std::mutex m_mutex;
+	std::vector<std::shared_ptr<BaseChecker> > m_running;//by thread, null while a thread has no property
+	std::vector<std::chrono::steady_clock::time_point> m_deadlines;//by thread, of the property it runs
+	int m_numProperties;
+	int m_nextProperty = 0;
+	int m_numUndecided;//not finished yet, running or waiting
+};
+
+}//namespace car
+
+#endif
@@ -0,0 +1,256 @@
+#include "PortfolioChecker.h"
+#include "BackwardChecker.h"
+#include "ForwardChecker.h"
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <csignal>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/wait.h>
+
+namespace car
+{
+	//the check of the worker process, for the signal that stops it
+	static BaseChecker* workerChecker = nullptr;
+
+	static void StopWorker(int)
+	{
+		if (workerChecker != nullptr)
+		{
+			workerChecker->Stop();
+		}
+	}
+
+	PortfolioChecker::PortfolioChecker(Settings settings, std::shared_ptr<AigerModel> model, const std::vector<Configuration>& configurations)
+	{
+		m_settings = settings;
+		m_model = model;
+		m_configurations = configurations;
+		m_log.reset(new Log(settings, model));
+	}
+
+	bool PortfolioChecker::Run()
+	{
+		auto begin = std::chrono::steady_clock::now();
+		//or the workers would print what is buffered once more
+		fflush(stdout);
+		for (int i = 0; i < m_configurations.size(); ++i)
+		{
+			pid_t pid = fork();
+			if (pid == 0)
+			{
+				Work(i);
+			}
+			m_workers.push_back(pid > 0 ? pid : 0);
+		}
+		std::vector<std::string> notes;
+		int numRunning = m_workers.size() - std::count(m_workers.begin(), m_workers.end(), 0);
+		while (numRunning > 0 && m_winner < 0)
+		{
+			int status;
+			pid_t pid = waitpid(-1, &status, 0);
+			if (pid < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				break;
+			}
+			int worker = std::find(m_workers.begin(), m_workers.end(), pid) - m_workers.begin();
+			if (worker == m_workers.size())
+			{
+				continue;
+			}
+			m_workers[worker] = 0;
+			--numRunning;
+			if (WIFSIGNALED(status))
+			{
+				notes.push_back("worker " + std::to_string(worker) + " crashed, signal " + std::to_string(WTERMSIG(status)));
+			}
+			else if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+			{
+				if (IsResultValid(Log::GetOutPath(m_configurations[worker].settings) + ".res"))
+				{
+					m_winner = worker;
+				}
+				else
+				{
+					notes.push_back("worker " + std::to_string(worker) + " gave a counterexample that does not hold");
+				}
+			}
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		Stop();
+		for (pid_t& pid : m_workers)
+		{
+			if (pid > 0)
+			{
+				waitpid(pid, nullptr, 0);
+				pid = 0;
+			}
+		}
+
+		for (int i = 0; i < m_configurations.size(); ++i)
+		{
+			m_log->PrintSth("worker " + std::to_string(i) + ":\t" + m_configurations[i].flags);
+		}
+		for (const std::string& note : notes)
+		{
+			m_log->PrintSth(note);
+		}
+		if (m_winner < 0)
+		{
+			m_log->PrintSth("no worker decided every property");
+			m_log->PrintSth("time out!!!");
+		}
+		else
+		{
+			std::ifstream res(Log::GetOutPath(m_configurations[m_winner].settings) + ".res");
+			m_log->m_res << res.rdbuf();
+			m_log->PrintSth("worker " + std::to_string(m_winner) + " decided first, after " + std::to_string(seconds) + " seconds");
+		}
+		//the results of the others are incomplete, their logs stay
+		for (int i = 0; i < m_configurations.size(); ++i)
+		{
+			std::remove((Log::GetOutPath(m_configurations[i].settings) + ".res").c_str());
+		}
+		return m_winner >= 0;
+	}
+
+	void PortfolioChecker::Stop()
+	{
+		//a worker stops at its next query and closes its files
+		for (pid_t pid : m_workers)
+		{
+			if (pid > 0)
+			{
+				kill(pid, SIGTERM);
+			}
+		}
+	}
+
+	void PortfolioChecker::Work(int worker)
+	{
+		const Settings& settings = m_configurations[worker].settings;
+		BaseChecker* checker;
+		if (settings.forward)
+		{
+			checker = new ForwardChecker(settings, m_model);
+		}
+		else
+		{
+			checker = new BackwardChecker(settings, m_model);
+		}
+		workerChecker = checker;
+		std::signal(SIGTERM, StopWorker);
+		int status = 1;
+		try
+		{
+			checker->Run();
+			status = 0;
+		}
+		catch (const CheckStopped&)
+		{
+			//gave up or was stopped, its log tells
+		}
+		std::signal(SIGTERM, SIG_IGN);
+		workerChecker = nullptr;
+		delete checker;
+		//leaves the buffers and files of the run to it
+		_exit(status);
+	}
+
+	bool PortfolioChecker::IsResultValid(const std::string& resPath)
+	{
+		aiger* aig = aiger_init();
+		if (aiger_open_and_read_from_file(aig, m_settings.aigFilePath.c_str()) != nullptr)
+		{
+			aiger_reset(aig);
+			return false;
+		}
+		//the gates in the order they can be evaluated in
+		aiger_reencode(aig);
+		std::ifstream res(resPath);
+		bool isValid = true;
+		std::string line;
+		while (isValid && std::getline(res, line))
+		{
+			if (line != "1")
+			{
+				continue;
+			}
+			std::string bad, latches;
+			std::getline(res, bad);
+			std::getline(res, latches);
+			std::vector<std::string> inputs;
+			while (std::getline(res, line) && line != ".")
+			{
+				inputs.push_back(line);
+			}
+			int badNo = bad.size() > 1 ? std::atoi(bad.c_str() + 1) : -1;
+			if (badNo < 0 || badNo >= aig->num_outputs || latches.size() != aig->num_latches || inputs.empty())
+			{
+				isValid = false;
+				break;
+			}
+			std::vector<unsigned char> values(aig->maxvar + 1, 0);
+			auto value = [&values](unsigned lit) {return static_cast<unsigned char>(values[lit >> 1] ^ (lit & 1));};
+			for (int i = 0; i < aig->num_latches; ++i)
+			{
+				unsigned reset = aig->latches[i].reset;
+				if (reset <= 1)
+				{
+					isValid = isValid && (latches[i] == 'x' || latches[i] - '0' == reset);
+					values[aig->latches[i].lit >> 1] = reset;
+				}
+				else
+				{
+					values[aig->latches[i].lit >> 1] = latches[i] == '1';
+				}
+			}
+			for (int step = 0; isValid && step < inputs.size(); ++step)
+			{
+				if (inputs[step].size() != aig->num_inputs)
+				{
+					isValid = false;
+					break;
+				}
+				for (int i = 0; i < aig->num_inputs; ++i)
+				{
+					values[aig->inputs[i].lit >> 1] = inputs[step][i] == '1';
+				}
+				for (int i = 0; i < aig->num_ands; ++i)
+				{
+					values[aig->ands[i].lhs >> 1] = value(aig->ands[i].rhs0) & value(aig->ands[i].rhs1);
+				}
+				for (int i = 0; i < aig->num_constraints; ++i)
+				{
+					isValid = isValid && value(aig->constraints[i].lit);
+				}
+				if (step + 1 == inputs.size())
+				{
+					isValid = isValid && value(aig->outputs[badNo].lit);
+				}
+				else
+				{
+					std::vector<unsigned char> next(aig->num_latches);
+					for (int i = 0; i < aig->num_latches; ++i)
+					{
+						next[i] = value(aig->latches[i].next);
+					}
+					for (int i = 0; i < aig->num_latches; ++i)
+					{
+						values[aig->latches[i].lit >> 1] = next[i];
+					}
+				}
+			}
+		}
+		aiger_reset(aig);
+		return isValid;
+	}
+
+}//namespace car
@@ -0,0 +1,49 @@
+#ifndef PORTFOLIOCHECKER_H
+#define PORTFOLIOCHECKER_H
+
+#include "BaseChecker.h"
+#include "Log.h"
+#include <memory>
+#include <vector>
+#include <string>
+#include <sys/types.h>
+
+namespace car
+{
+
+///
+//runs several checker configurations on the same model, each one in a process of its own,
+//so that a worker that crashes takes only itself down and a check restricting the model to a cone touches no other.
+//the first one to decide every property wins: its result is the result of the run and the others are stopped.
+//a counterexample of the winner is replayed on the model first, a worker whose one does not hold does not win
+///
+class PortfolioChecker : public BaseChecker
+{
+public:
+	struct Configuration
+	{
+		std::string flags;//as given on the command line, for the log
+		Settings settings;
+	};
+
+	PortfolioChecker(Settings settings, std::shared_ptr<AigerModel> model, const std::vector<Configuration>& configurations);
+	bool Run();
+	void Stop();
+private:
+	//in the process of the worker, which it ends: with 0 when its check decided every property
+	void Work(int worker);
+	//the counterexamples in the result of a worker hold on the model as read from its file
+	bool IsResultValid(const std::string& resPath);
+
+	Settings m_settings;
+	std::shared_ptr<AigerModel> m_model;
+	std::vector<Configuration> m_configurations;
+	std::vector<pid_t> m_workers;//0 once the worker has ended
+	std::shared_ptr<Log> m_log;
+
+	int m_winner = -1;
+};
+
+}//namespace car
+
+#endif
@@ -2,24 +2,49 @@
 #include "BackwardChecker.h"
 #include "ForwardChecker.h"
 #include "CleanCARCheckerF.h"
+#include "PortfolioChecker.h"
+#include "MultiPropertyChecker.h"
 #include "AigerModel.h"
 #include "Settings.h"
 #include <string.h>
 #include "restart.h"
 #include <memory>
+#include <thread>
+#include <sstream>
 
 using namespace car;
 using namespace std;
 
 void PrintUsage ();
 Settings GetArgv(int argc, char **argv);
+SatBackend GetSatBackend(const char* name);
+vector<PortfolioChecker::Configuration> GetPortfolio(int argc, char** argv, const Settings& settings);
+
+//the configurations of -portfolio, most promising first; each adds its flags to those of the run.
+//-unroll is left out, it has been checked less than the others; so is -f with -rotation, -partial or -prop,
+//as they are not sound yet, which GetPortfolio also clears when the run has them
+const char* portfolioFlags[] = {
+    "-b -inter -rotation", "-f", "-b", "-b -end", "-b -muc", 
+    "-f -inter", "-b -prop", "-b -restart", "-f -muc", "-b -simp", "-b -end -inter -rotation"};
 
 int main(int argc, char** argv)
 {
     Settings settings = GetArgv(argc, argv);
-    shared_ptr<AigerModel> aigerModel(new AigerModel(settings.aigFilePath));
+    shared_ptr<AigerModel> aigerModel(new AigerModel(settings.aigFilePath, settings.mergeEquivalences));
+    //the same for every check of the model, so they are set once, before any check runs on a thread of its own
+    State::numInputs = aigerModel->GetNumInputs();
+    State::numLatches = aigerModel->GetNumLatches();
+    State::keepInputs = !settings.lazyInputs;
     BaseChecker* checker;
-    if (settings.forward)
+    if (settings.portfolio)
+    {
+        checker = new PortfolioChecker(settings, aigerModel, GetPortfolio(argc, argv, settings));
+    }
+    else if (settings.jobs > 1)
+    {
+        checker = new MultiPropertyChecker(settings, aigerModel);
+    }
+    else if (settings.forward)
     {
         checker = new ForwardChecker(settings, aigerModel);
     }
@@ -45,11 +70,30 @@ void PrintUsage()
     printf ("       -h              print help information\n");
     printf ("       -debug          print debug info\n");
     printf ("       -muc            active the MUC extraction\n");
-    printf ("       -dead           active the dead-state detection\n");
+    printf ("       -muc-budget n   at most n SAT queries per MUC extraction, -1 for no limit (Default = 256)\n");
+    printf ("       -dead           block the start states without predecessors for good (forward checking)\n");
     printf ("       -partial        active the partial-state generation\n");
     printf ("       -depth          restart-depth mode\n");
     printf ("       -restart        active restart policy\n");
     printf ("       -vis            output visualization\n");
+    printf ("       -unroll k       unroll the transition relation k steps per SAT query (Default = 1)\n");
+    printf ("       -simp           simplify the transition relation by variable elimination before checking\n");
+    printf ("       -eq             merge the latches and gates proved equivalent or constant by simulation and induction\n");
+    printf ("       -lazy-inputs    keep no inputs in the states, find them again along a counterexample\n");
+    printf ("       -reuse-frames   forward checking keeps its frames and solvers from one property to the next\n");
+    printf ("       -sat s          SAT backend of all solvers, minisat or cadical (Default = minisat)\n");
+    printf ("       -sat-main s     SAT backend of the main solver\n");
+    printf ("       -sat-inv s      SAT backend of the invariant solver\n");
+    printf ("       -sat-start s    SAT backend of the start solver (forward checking)\n");
+    printf ("       -sat-partial s  SAT backend of the partial-state solver (forward checking)\n");
+    printf ("       -conflicts n    give up a check whose SAT query takes more than n conflicts\n");
+    printf ("       -props n        give up a check whose SAT query takes more than n propagations (minisat only, cadical bounds conflicts only)\n");
+    printf ("       -trace          record the clauses and solves of each solver in <output directory>/<name>.<role>.trace\n");
+    printf ("       -portfolio      run several configurations on threads, the first one to decide every property wins\n");
+    printf ("       -threads n      the threads of -portfolio, one configuration each (Default = one per core)\n");
+    printf ("       -jobs n         check up to n properties at once, each one starts with its share of the time left\n");
+    printf ("       -explore n      backward checking explores the states of a level on n threads that share the frames\n");
+    printf ("                       and steal work from each other (without -rotation, -restart, -vis and -debug)\n");
     printf ("NOTE: -f and -b cannot be used together!\n");
     exit (0);
 }
@@ -98,6 +142,10 @@ Settings GetArgv(int argc, char** argv)
         {
             settings.muc = true;
         }
+        else if (strcmp(argv[i], "-muc-budget") == 0 && i+1 < argc)
+        {
+            settings.mucBudget = stoi(argv[++i]);
+        }
         else if (strcmp(argv[i], "-dead") == 0)
         {
             settings.dead = true;
@@ -118,6 +166,91 @@ Settings GetArgv(int argc, char** argv)
         {
             settings.condition = RestartCondition::Depth;
         }
+        else if (strcmp(argv[i], "-unroll") == 0)
+        {
+            settings.unroll = stoi(argv[++i]);
+            if (settings.unroll < 1)
+            {
+                PrintUsage ();
+            }
+        }
+        else if (strcmp(argv[i], "-simp") == 0)
+        {
+            settings.simplify = true;
+        }
+        else if (strcmp(argv[i], "-eq") == 0)
+        {
+            settings.mergeEquivalences = true;
+        }
+        else if (strcmp(argv[i], "-lazy-inputs") == 0)
+        {
+            settings.lazyInputs = true;
+        }
+        else if (strcmp(argv[i], "-reuse-frames") == 0)
+        {
+            settings.reuseFrames = true;
+        }
+        else if (strcmp(argv[i], "-sat") == 0 && i+1 < argc)
+        {
+            SatBackend backend = GetSatBackend(argv[++i]);
+            settings.mainSat = settings.invSat = settings.startSat = settings.partialSat = backend;
+        }
+        else if (strcmp(argv[i], "-sat-main") == 0 && i+1 < argc)
+        {
+            settings.mainSat = GetSatBackend(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-sat-inv") == 0 && i+1 < argc)
+        {
+            settings.invSat = GetSatBackend(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-sat-start") == 0 && i+1 < argc)
+        {
+            settings.startSat = GetSatBackend(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-sat-partial") == 0 && i+1 < argc)
+        {
+            settings.partialSat = GetSatBackend(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-conflicts") == 0 && i+1 < argc)
+        {
+            settings.conflictBudget = stoll(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-props") == 0 && i+1 < argc)
+        {
+            settings.propagationBudget = stoll(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-portfolio") == 0)
+        {
+            settings.portfolio = true;
+        }
+        else if (strcmp(argv[i], "-threads") == 0 && i+1 < argc)
+        {
+            settings.threads = stoi(argv[++i]);
+            if (settings.threads < 1)
+            {
+                PrintUsage ();
+            }
+        }
+        else if (strcmp(argv[i], "-jobs") == 0 && i+1 < argc)
+        {
+            settings.jobs = stoi(argv[++i]);
+            if (settings.jobs < 1)
+            {
+                PrintUsage ();
+            }
+        }
+        else if (strcmp(argv[i], "-explore") == 0 && i+1 < argc)
+        {
+            settings.explore = stoi(argv[++i]);
+            if (settings.explore < 1)
+            {
+                PrintUsage ();
+            }
+        }
+        else if (strcmp(argv[i], "-trace") == 0)
+        {
+            settings.trace = true;
+        }
         else if (strcmp(argv[i], "-vis") == 0)
         {
             settings.Visualization = true;
@@ -147,4 +280,62 @@ Settings GetArgv(int argc, char** argv)
         }
     }
     return settings;
-}
\ No newline at end of file
+}
+
+//the settings of each worker: the flags of the run with those of its configuration after them.
+//with more threads than configurations, the configurations are repeated on CaDiCaL
+vector<PortfolioChecker::Configuration> GetPortfolio(int argc, char** argv, const Settings& settings)
+{
+    int numFlags = sizeof(portfolioFlags) / sizeof(portfolioFlags[0]);
+    int numWorkers = settings.threads > 0 ? settings.threads : max(1u, thread::hardware_concurrency());
+    numWorkers = min(numWorkers, 2*numFlags);
+    vector<PortfolioChecker::Configuration> configurations;
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        string flags = portfolioFlags[i % numFlags];
+        if (i >= numFlags)
+        {
+            flags += " -sat cadical";
+        }
+        vector<string> words;
+        istringstream in(flags);
+        for (string word; in >> word;)
+        {
+            words.push_back(word);
+        }
+        vector<char*> args(argv, argv + argc);
+        for (string& word : words)
+        {
+            args.push_back(&word[0]);
+        }
+        PortfolioChecker::Configuration configuration;
+        configuration.flags = flags;
+        configuration.settings = GetArgv(args.size(), args.data());
+        if (configuration.settings.forward)
+        {
+            //the flags of the run may bring them in, and they are not sound with -f yet
+            configuration.settings.rotate = false;
+            configuration.settings.partial = false;
+            configuration.settings.propagation = false;
+        }
+        configuration.settings.portfolio = false;
+        configuration.settings.Visualization = false;
+        configuration.settings.worker = i;
+        configurations.push_back(configuration);
+    }
+    return configurations;
+}
+
+SatBackend GetSatBackend(const char* name)
+{
+    if (strcmp(name, "minisat") == 0)
+    {
+        return SatBackend::Minisat;
+    }
+    else if (strcmp(name, "cadical") == 0)
+    {
+        return SatBackend::Cadical;
+    }
+    PrintUsage ();
+    return SatBackend::Minisat;
+}
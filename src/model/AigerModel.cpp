@@ -1,10 +1,47 @@
 #include "AigerModel.h"
+#include "EquivalenceSweeper.h"
+#include "../sat/minisat/simp/SimpSolver.h"
+#include <algorithm>
 
 
 namespace car
 {
 
-AigerModel::AigerModel(string aigFilePath)
+///
+//a SimpSolver that hands out the clauses left after the elimination
+///
+class ClauseSimplifier : public Minisat::SimpSolver
+{
+public:
+    void GetClauses(Cnf& res)
+    {
+        //the units found on the way are only on the trail
+        for (int i = 0; i < trail.size(); ++i)
+        {
+            res.Push({GetId(trail[i])});
+        }
+        for (int i = 0; i < clauses.size(); ++i)
+        {
+            const Minisat::Clause& c = ca[clauses[i]];
+            if (c.mark())
+            {
+                continue;
+            }
+            std::vector<int> clause;
+            clause.reserve(c.size());
+            for (int j = 0; j < c.size(); ++j)
+            {
+                clause.push_back(GetId(c[j]));
+            }
+            res.Push(clause);
+        }
+    }
+
+private:
+    inline int GetId(Minisat::Lit l) {return Minisat::sign(l) ? -(Minisat::var(l) + 1) : Minisat::var(l) + 1;}
+};
+
+AigerModel::AigerModel(string aigFilePath, bool mergeEquivalences)
 {
     aiger* aig = aiger_init();
     aiger_open_and_read_from_file(aig, aigFilePath.c_str());
@@ -16,10 +53,40 @@ AigerModel::AigerModel(string aigFilePath)
     {
         aiger_reencode(aig);
     }
+    if (mergeEquivalences)
+    {
+        MergeEquivalences(aig);
+    }
 
     Init(aig);
 }
 
+void AigerModel::MergeEquivalences(aiger* aig)
+{
+    std::vector<unsigned> repr = EquivalenceSweeper(aig).Sweep();
+    //the merged ones stay in the aiger, but nothing refers to them any more,
+    //so a merged latch falls out of every cone and a merged gate is never encoded.
+    //the constraints are left as they are, the sweeper keeps their logic out of the classes
+    auto substitute = [&repr](unsigned& lit) {lit = repr[lit/2] ^ (lit & 1);};
+    for (int i = 0; i < aig->num_ands; ++i)
+    {
+        substitute(aig->ands[i].rhs0);
+        substitute(aig->ands[i].rhs1);
+    }
+    for (int i = 0; i < aig->num_latches; ++i)
+    {
+        substitute(aig->latches[i].next);
+    }
+    for (int i = 0; i < aig->num_outputs; ++i)
+    {
+        substitute(aig->outputs[i].lit);
+    }
+    for (int i = 0; i < aig->num_bad; ++i)
+    {
+        substitute(aig->bad[i].lit);
+    }
+}
+
 
 void AigerModel::Init(aiger* aig)
 {
@@ -66,8 +133,7 @@ void AigerModel::CollectConstraints(const aiger* aig)
 {
     for (int i = 0; i < aig->num_constraints; ++i)
     {
-        int id = static_cast<int>(aig->constraints[i].lit);
-        m_constraints.push_back((id%2 == 0) ?(id/2) : -(id/2));
+        m_constraints.push_back(GetRootId(aig->constraints[i].lit));
     }
 }
 
@@ -75,8 +141,7 @@ void AigerModel::CollectOutputs(const aiger* aig)
 {
     for (int i = 0; i < aig->num_outputs; ++i)
     {
-        int id = static_cast<int>(aig->outputs[i].lit);
-        m_outputs.push_back((id%2 == 0) ?(id/2) : -(id/2));
+        m_outputs.push_back(GetRootId(aig->outputs[i].lit));
     }
 }
 
@@ -137,6 +202,7 @@ void AigerModel::CollectClauses(const aiger* aig)
 {
     //contraints, outputs and latches gates are stored in order, 
         //as the need for start solver construction
+    CollectGateLeaves(aig);
     std::unordered_set<unsigned> exist_gates;
     std::vector<unsigned> gates;
     //gates.resize(max_id_ + 1, 0);
@@ -145,21 +211,17 @@ void AigerModel::CollectClauses(const aiger* aig)
 
     for (std::vector<unsigned>::iterator it = gates.begin(); it != gates.end(); it++)
     {
-        aiger_and* aa = aiger_is_and(const_cast<aiger*>(aig), *it);
-        if (aa == NULL)
-        {
-            //placeholder
-        }
-        AddAndGateToClause(aa);
+        AddGateToClause(*it, false);
     }
 
     //add constraints[i] as clauses
     for(auto it = m_constraints.begin(); it != m_constraints.end(); it++)
     {
-        m_clauses.emplace_back(std::vector<int>{*it});
+        m_clauses->Push({*it});
     }
+    m_clauseOwners->resize(m_clauses->size(), 0);
 
-    m_outputsStart = m_clauses.size();
+    m_outputsStart = m_clauses->size();
     //create clauses for outputs
     std::vector<unsigned>().swap(gates);
     CollectNecessaryAndGates(aig, aig->outputs, aig->num_outputs, exist_gates, gates, false);
@@ -167,14 +229,9 @@ void AigerModel::CollectClauses(const aiger* aig)
     for (std::vector<unsigned>::iterator it = gates.begin(); it != gates.end(); it++)
     {
         if (*it == 0) continue;
-        aiger_and* aa = aiger_is_and(const_cast<aiger*>(aig), *it);
-        if (aa == NULL)
-        {
-            //placeholder
-        }
-        AddAndGatePrimeToClause(aa);
+        AddGateToClause(*it, true);
     }
-    m_latchesStart = m_clauses.size();
+    m_latchesStart = m_clauses->size();
 
     //create clauses for latches
     std::vector<unsigned>().swap(gates);
@@ -182,24 +239,107 @@ void AigerModel::CollectClauses(const aiger* aig)
     for (std::vector<unsigned>::iterator it = gates.begin(); it != gates.end(); it++)
     {
         if (*it == 0) continue;
-        aiger_and* aa = aiger_is_and(const_cast<aiger*>(aig), *it);
-        if (aa == NULL)
-        {
-            //placeholder
-        }
-        AddAndGateToClause(aa);
+        AddGateToClause(*it, false);
     }
 
     // creat clause for prime(it->first) <-> it->second
     for (auto it = m_nextValueOfLatch.begin(); it != m_nextValueOfLatch.end(); it++)
     {
-        m_clauses.emplace_back(std::vector<int>{-GetPrime(it->first), it->second});
-        m_clauses.emplace_back(std::vector<int>{GetPrime(it->first), -(it->second)});
+        m_clauses->Push({-GetPrime(it->first), it->second});
+        m_clauses->Push({GetPrime(it->first), -(it->second)});
+        m_clauseOwners->resize(m_clauses->size(), it->first);
     }
 
     //create clauses for true and false
-    m_clauses.emplace_back(std::vector<int>{m_trueId});
-    m_clauses.emplace_back(std::vector<int>{GetPrime(m_trueId)});
+    m_clauses->Push({m_trueId});
+    m_clauses->Push({GetPrime(m_trueId)});
+    m_clauseOwners->resize(m_clauses->size(), 0);
+
+    CollectFanins();
+    //only needed while encoding
+    std::vector<std::vector<unsigned> >().swap(m_gateLeaves);
+    std::vector<unsigned char>().swap(m_polarity);
+}
+
+void AigerModel::CollectGateLeaves(const aiger* aig)
+{
+    //a positive and-gate input that nothing else refers to is folded into the gate reading it,
+    //so that every gate kept stands for the and of its leaves
+    std::vector<int> refs(aig->maxvar + 1, 0);
+    std::vector<bool> isNegRef(aig->maxvar + 1, false);
+    for (int i = 0; i < aig->num_ands; ++i)
+    {
+        for (unsigned rhs : {aig->ands[i].rhs0, aig->ands[i].rhs1})
+        {
+            ++refs[rhs/2];
+            if (rhs % 2 != 0) isNegRef[rhs/2] = true;
+        }
+    }
+    //the roots are read from outside the gates, so they keep a variable of their own.
+    //bad and the next states are assumed in both polarities, a constraint only the way it holds
+    m_polarity.assign(aig->maxvar + 1, 0);
+    for (int i = 0; i < aig->num_outputs; ++i)
+    {
+        refs[aig->outputs[i].lit/2] += 2;
+        m_polarity[aig->outputs[i].lit/2] = PositivePolarity | NegativePolarity;
+    }
+    for (int i = 0; i < aig->num_latches; ++i)
+    {
+        refs[aig->latches[i].next/2] += 2;
+        m_polarity[aig->latches[i].next/2] = PositivePolarity | NegativePolarity;
+    }
+    for (int i = 0; i < aig->num_constraints; ++i)
+    {
+        unsigned lit = aig->constraints[i].lit;
+        refs[lit/2] += 2;
+        m_polarity[lit/2] |= (lit % 2 == 0) ? PositivePolarity : NegativePolarity;
+    }
+
+    //gates come after their inputs, so going down the gates sees every reader of a gate before the gate
+    m_gateLeaves.assign(aig->maxvar + 1, std::vector<unsigned>());
+    std::vector<unsigned> stack;
+    for (int i = aig->num_ands - 1; i >= 0; --i)
+    {
+        const aiger_and& aa = aig->ands[i];
+        unsigned var = aa.lhs/2;
+        if (m_polarity[var] == 0 || IsTrue(aa.lhs) || IsFalse(aa.lhs))
+        {
+            continue;
+        }
+        std::vector<unsigned>& leaves = m_gateLeaves[var];
+        stack.assign({aa.rhs0, aa.rhs1});
+        while (!stack.empty())
+        {
+            unsigned lit = stack.back();
+            stack.pop_back();
+            if (IsTrue(lit))
+            {
+                continue;
+            }
+            aiger_and* input = IsAndGate(lit, aig);
+            if (input != nullptr && lit % 2 == 0 && refs[lit/2] == 1 && !isNegRef[lit/2])
+            {
+                stack.push_back(input->rhs0);
+                stack.push_back(input->rhs1);
+                continue;
+            }
+            leaves.push_back(lit);
+        }
+        std::sort(leaves.begin(), leaves.end());
+        leaves.erase(std::unique(leaves.begin(), leaves.end()), leaves.end());
+        for (unsigned lit : leaves)
+        {
+            if (IsAndGate(lit, aig) != nullptr)
+            {
+                unsigned char polarity = m_polarity[var];
+                if (lit % 2 != 0)
+                {
+                    polarity = ((polarity & PositivePolarity) ? NegativePolarity : 0) | ((polarity & NegativePolarity) ? PositivePolarity : 0);
+                }
+                m_polarity[lit/2] |= polarity;
+            }
+        }
+    }
 }
 
 void AigerModel::CollectNecessaryAndGates(const aiger* aig, const aiger_symbol* as, const int as_size, 
@@ -232,16 +372,7 @@ void AigerModel::CollectNecessaryAndGatesFromConstrain(const aiger* aig, const a
 {
     for (int i = 0; i < as_size; ++i)
     {
-        aiger_and* aa;
-        aa = IsAndGate(as[i].lit, aig);
-        if (aa == NULL)
-        {
-            if (IsFalse(as[i].lit))
-            {
-                m_outputs[i] = m_falseId;
-            }
-        }
-        FindAndGates(aa, aig, exist_gates, gates);
+        FindAndGates(IsAndGate(as[i].lit, aig), aig, exist_gates, gates);
     }
 }
 
@@ -264,64 +395,161 @@ void AigerModel::FindAndGates(const aiger_and* aa, const aiger* aig, std::unorde
     FindAndGates(aa1, aig, exist_gates, gates);
 }
 
-void AigerModel::AddAndGateToClause(const aiger_and* aa)
+void AigerModel::AddGateToClause(unsigned gate, bool prime)
 {
-    if (aa == nullptr || IsTrue(aa->lhs) || IsFalse(aa->lhs))
+    //a gate folded into its reader has no leaves and no clauses
+    std::vector<unsigned>& leaves = m_gateLeaves[gate/2];
+    if (leaves.empty())
     {
-        //placeholder
+        return;
     }
-		
-	if (IsTrue(aa->rhs0))
-	{
-		m_clauses.emplace_back(std::vector<int>{GetCarId(aa->lhs), -GetCarId(aa->rhs1)});
-        m_clauses.emplace_back(std::vector<int>{-GetCarId(aa->lhs), GetCarId(aa->rhs1)});
-	}
-	else if (IsTrue(aa->rhs1))
-	{
-        m_clauses.emplace_back(std::vector<int>{GetCarId(aa->lhs), -GetCarId(aa->rhs0)});
-        m_clauses.emplace_back(std::vector<int>{-GetCarId(aa->lhs), GetCarId(aa->rhs0)});
-	}
-	else
-	{
-        m_clauses.emplace_back(std::vector<int>{GetCarId(aa->lhs), -GetCarId(aa->rhs0), -GetCarId(aa->rhs1)});
-        m_clauses.emplace_back(std::vector<int>{-GetCarId(aa->lhs), GetCarId(aa->rhs0)});
-        m_clauses.emplace_back(std::vector<int>{-GetCarId(aa->lhs), GetCarId(aa->rhs1)});
-	}		
+    //the gate implies its leaves where it is needed true, the leaves imply the gate where it is needed false
+    unsigned char polarity = m_polarity[gate/2];
+    for (int level = 0; level <= (prime ? 1 : 0); ++level)
+    {
+        int id = GetPrime(GetCarId(gate), level);
+        if (polarity & PositivePolarity)
+        {
+            for (unsigned lit : leaves)
+            {
+                m_clauses->Push({-id, GetPrime(GetCarId(lit), level)});
+            }
+        }
+        if (polarity & NegativePolarity)
+        {
+            std::vector<int> clause;
+            clause.reserve(leaves.size() + 1);
+            clause.push_back(id);
+            for (unsigned lit : leaves)
+            {
+                clause.push_back(-GetPrime(GetCarId(lit), level));
+            }
+            m_clauses->Push(clause);
+        }
+    }
+    m_clauseOwners->resize(m_clauses->size(), gate/2);
 }
 
-void AigerModel::AddAndGatePrimeToClause(const aiger_and* aa)
+void AigerModel::CollectFanins()
 {
-    if (aa == nullptr || IsTrue(aa->lhs) || IsFalse(aa->lhs))
+    m_faninStart->assign(m_maxId + 1, 0);
+    for (int v = 0; v < m_maxId; ++v)
     {
-        //placeholder
+        (*m_faninStart)[v] = m_fanins->size();
+        if (v < m_gateLeaves.size())
+        {
+            for (unsigned lit : m_gateLeaves[v])
+            {
+                m_fanins->push_back(lit/2);
+            }
+        }
+        auto it = m_nextValueOfLatch.find(v);
+        if (it != m_nextValueOfLatch.end())
+        {
+            m_fanins->push_back(abs(it->second));
+        }
     }
-		
-	if (IsTrue(aa->rhs0))
-	{
-		m_clauses.emplace_back(std::vector<int>{GetCarId(aa->lhs), -GetCarId(aa->rhs1)});
-        m_clauses.emplace_back(std::vector<int>{-GetCarId(aa->lhs), GetCarId(aa->rhs1)});
-        //add prime 
-        m_clauses.emplace_back(std::vector<int>{GetPrime(GetCarId(aa->lhs)), GetPrime(-GetCarId(aa->rhs1))});
-        m_clauses.emplace_back(std::vector<int>{GetPrime(-GetCarId(aa->lhs)), GetPrime(GetCarId(aa->rhs1))});
-	}
-	else if (IsTrue(aa->rhs1))
-	{
-        m_clauses.emplace_back(std::vector<int>{GetCarId(aa->lhs), -GetCarId(aa->rhs0)});
-        m_clauses.emplace_back(std::vector<int>{-GetCarId(aa->lhs), GetCarId(aa->rhs0)});
-        //add prime
-        m_clauses.emplace_back(std::vector<int>{GetPrime(GetCarId(aa->lhs)), GetPrime(-GetCarId(aa->rhs0))});
-        m_clauses.emplace_back(std::vector<int>{GetPrime(-GetCarId(aa->lhs)), GetPrime(GetCarId(aa->rhs0))});
-	}
-	else
-	{
-        m_clauses.emplace_back(std::vector<int>{GetCarId(aa->lhs), -GetCarId(aa->rhs0), -GetCarId(aa->rhs1)});
-        m_clauses.emplace_back(std::vector<int>{-GetCarId(aa->lhs), GetCarId(aa->rhs0)});
-        m_clauses.emplace_back(std::vector<int>{-GetCarId(aa->lhs), GetCarId(aa->rhs1)});
-        //add prime
-        m_clauses.emplace_back(std::vector<int>{GetPrime(GetCarId(aa->lhs)), GetPrime(-GetCarId(aa->rhs0)), GetPrime(-GetCarId(aa->rhs1))});
-        m_clauses.emplace_back(std::vector<int>{GetPrime(-GetCarId(aa->lhs)), GetPrime(GetCarId(aa->rhs0))});
-        m_clauses.emplace_back(std::vector<int>{GetPrime(-GetCarId(aa->lhs)), GetPrime(GetCarId(aa->rhs1))});
-	}		
+    (*m_faninStart)[m_maxId] = m_fanins->size();
+}
+
+void AigerModel::SetCone(const std::vector<int>& badIds)
+{
+    m_inCone.assign(m_maxId, false);
+    std::vector<int> stack;
+    for (int id : badIds)
+    {
+        stack.push_back(abs(id));
+    }
+    for (int id : m_constraints)
+    {
+        stack.push_back(abs(id));
+    }
+    while (!stack.empty())
+    {
+        int v = stack.back();
+        stack.pop_back();
+        if (m_inCone[v])
+        {
+            continue;
+        }
+        m_inCone[v] = true;
+        for (int i = (*m_faninStart)[v]; i < (*m_faninStart)[v+1]; ++i)
+        {
+            if (!m_inCone[(*m_fanins)[i]])
+            {
+                stack.push_back((*m_fanins)[i]);
+            }
+        }
+    }
+
+    m_coneClauses.clear();
+    for (int i = 0; i < m_clauses->size(); ++i)
+    {
+        if ((*m_clauseOwners)[i] == 0 || m_inCone[(*m_clauseOwners)[i]])
+        {
+            m_coneClauses.Push((*m_clauses)[i]);
+        }
+    }
+    m_hasCone = true;
+    m_isSimplified = false;
+    m_simplifiedClauses.clear();
+}
+
+void AigerModel::Simplify()
+{
+    ClauseSimplifier simplifier;
+    auto getLit = [&simplifier](int id)
+    {
+        while (abs(id) > simplifier.nVars()) simplifier.newVar();
+        return id > 0 ? Minisat::mkLit(id-1) : ~Minisat::mkLit(-id-1);
+    };
+    //the variables the solvers assume, read or add clauses over.
+    //the unrolled copies of T are renamed copies of these clauses, so the copies keep them too
+    std::vector<int> frozen;
+    for (int i = 1; i <= m_numInputs + m_numLatches; ++i)
+    {
+        frozen.push_back(i);
+    }
+    for (int i = m_numInputs + 1; i <= m_numInputs + m_numLatches; ++i)
+    {
+        frozen.push_back(GetPrime(i));
+    }
+    for (int id : m_outputs)
+    {
+        frozen.push_back(abs(id));
+        frozen.push_back(GetPrime(abs(id)));
+    }
+    for (int id : m_constraints)
+    {
+        frozen.push_back(abs(id));
+    }
+    frozen.push_back(m_trueId);
+    frozen.push_back(GetPrime(m_trueId));
+    for (int id : frozen)
+    {
+        simplifier.setFrozen(Minisat::var(getLit(id)), true);
+    }
+
+    Minisat::vec<Minisat::Lit> literals;
+    const Cnf& clauses = m_hasCone ? m_coneClauses : *m_clauses;
+    for (int i = 0; i < clauses.size(); ++i)
+    {
+        Lemma clause = clauses[i];
+        literals.clear();
+        for (int id : clause)
+        {
+            literals.push(getLit(id));
+        }
+        simplifier.addClause(literals);
+    }
+    //an inconsistent T is left to the solvers as it is
+    if (!simplifier.eliminate(true))
+    {
+        return;
+    }
+    m_simplifiedClauses.clear();
+    simplifier.GetClauses(m_simplifiedClauses);
+    m_isSimplified = true;
 }
 
 inline aiger_and* AigerModel::IsAndGate(const unsigned id, const aiger* aig)
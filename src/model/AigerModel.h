@@ -10,7 +10,9 @@ extern "C"
 #include <unordered_set>
 #include <vector>
 #include <unordered_map>
+#include <memory>
 #include <assert>
+#include "Cnf.h"
 
 typedef std::string string;
 
@@ -21,7 +23,8 @@ namespace car
 class AigerModel
 {
 public:
-    AigerModel (string aigFilePath);
+    //mergeEquivalences merges the latches and gates proved equal or constant in every reachable state before encoding
+    AigerModel (string aigFilePath, bool mergeEquivalences = false);
 
     bool IsTrue(const unsigned id)
     {
@@ -66,6 +69,13 @@ public:
         return ((id % 2 == 0) ? (id / 2) : -(id / 2));
     }
 
+    //the id of a literal read from outside the gates. a constant gate gets no clauses, 
+    //so it is read as m_trueId or m_falseId
+    int GetRootId(const unsigned lit)
+    {
+        return IsTrue(lit) ? m_trueId : (IsFalse(lit) ? m_falseId : GetCarId(lit));
+    }
+
 #pragma region get & set
     int GetNumInputs() {return m_numInputs;}
     int GetNumLatches() {return m_numLatches;}
@@ -114,12 +124,37 @@ public:
     
 
 
-    std::vector<std::vector<int> >& GetClause() {return m_clauses;}
+    const Cnf& GetClause() {return *m_clauses;}
+
+    //the clauses of T the main solvers load, restricted to the cone of the current bad once SetCone() has run,
+    //and simplified once Simplify() has run
+    const Cnf& GetTransitionClause() 
+    {
+        return m_isSimplified ? m_simplifiedClauses : (m_hasCone ? m_coneClauses : *m_clauses);
+    }
+
+    //restricts T to the transitive fan-in of badId and the constraints, through the next states of the latches met.
+    //drops an earlier simplification, which was done for another cone
+    void SetCone(int badId) {SetCone(std::vector<int>(1, badId));}
+
+    //the union of the cones of several bads, for checks that share their frames
+    void SetCone(const std::vector<int>& badIds);
+
+    //a latch outside the cone can take any value without changing whether bad is reachable,
+    //so the states leave it out
+    bool IsInCone(int id) {return !m_hasCone || m_inCone[abs(id)];}
+
+    //bounded variable elimination over the clauses of T, shared by every main solver afterwards.
+    //inputs, latches, primed latches, bad and constraint variables are frozen, so only gates go away
+    void Simplify();
 #pragma endregion
 
 #pragma region private methods
 private:
     void Init (aiger* aig);
+
+    //replaces every reference to a merged latch or gate by the one it is equal to
+    void MergeEquivalences (aiger* aig);
     
     void CollectTrues (const aiger* aig);
 
@@ -141,9 +176,14 @@ private:
 
     void FindAndGates(const aiger_and* aa, const aiger* aig, std::unordered_set<unsigned>& exist_gates, std::vector<unsigned>& gates);
 	
-    void AddAndGateToClause (const aiger_and* aa);
+    //the leaves and the needed polarities of the gates in the cones of the roots
+    void CollectGateLeaves(const aiger* aig);
 
-    void AddAndGatePrimeToClause (const aiger_and* aa);
+    //the clauses of the gate as an and of its leaves, also on the primed level if prime is set
+    void AddGateToClause(unsigned gate, bool prime);
+
+    //the fan-ins of the gates kept and the next states of the latches, to find cones by
+    void CollectFanins();
 
 	inline aiger_and* IsAndGate (const unsigned id, const aiger* aig);
 
@@ -166,10 +206,27 @@ private:
     std::vector<int> m_initialState;   
 	std::vector<int> m_outputs; 
 	std::vector<int> m_constraints; 
-    std::vector<std::vector<int> > m_clauses; //CNF, e.g. (a|b|c) * (-a|c)
+    //only read once the model is built, so a copy for another check shares them; the cone and simplification below are its own
+    std::shared_ptr<Cnf> m_clauses = std::make_shared<Cnf>(); //CNF, e.g. (a|b|c) * (-a|c)
+    std::shared_ptr<std::vector<int> > m_clauseOwners = std::make_shared<std::vector<int> >();//the variable whose definition clause i belongs to, 0 for clauses every cone keeps
+    std::shared_ptr<std::vector<int> > m_faninStart = std::make_shared<std::vector<int> >();//the fan-ins of variable v are fanins[faninStart[v]..faninStart[v+1])
+    std::shared_ptr<std::vector<int> > m_fanins = std::make_shared<std::vector<int> >();
+    Cnf m_coneClauses;
+    std::vector<bool> m_inCone;//by variable
+    bool m_hasCone = false;
+    Cnf m_simplifiedClauses;
+    bool m_isSimplified = false;
     std::unordered_set<int> m_trues;    //variables that are always true
     std::unordered_map<int, int> m_nextValueOfLatch;
     std::unordered_map<int, std::vector<int> > m_preValueOfLatch;   //e.g. 6 16, 8 16. 16 -> 6,8
+
+    enum GatePolarity
+    {
+        PositivePolarity = 1,//the gate is needed true somewhere
+        NegativePolarity = 2
+    };
+    std::vector<std::vector<unsigned> > m_gateLeaves;//by aiger variable, empty for a gate folded into its reader
+    std::vector<unsigned char> m_polarity;//by aiger variable, GatePolarity bits
     
 #pragma endregion
 };
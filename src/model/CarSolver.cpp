@@ -1,10 +1,11 @@
 #include "CarSolver.h"
 #include <algorithm>
+#include <chrono>
 using namespace Minisat;
 
 namespace  car
 {
-	CarSolver::CarSolver() {}
+	CarSolver::CarSolver(): m_assumptions(assumptions) {}
 
 	CarSolver::~CarSolver()
 	{
@@ -13,19 +14,7 @@ namespace  car
 
 	bool CarSolver::SolveWithAssumption()
 	{
-		lbool result = solveLimited(m_assumptions);
-		if (result == l_True)
-		{
-			return true;
-		}
-		else if(result == l_False)
-		{
-			return false;
-		}
-		else // result == l_Undef
-		{
-			//placeholder
-		}
+		return SolveAssumptions() == l_True;
 	}
 
 	 bool CarSolver::SolveWithAssumption(std::vector<int>& assumption)
@@ -35,42 +24,38 @@ namespace  car
 		{
 			m_assumptions.push(GetLit(*it));
 		}
-		lbool result = solveLimited(m_assumptions);
-		if (result == l_True)
-		{
-			return true;
-		}
-		else if(result == l_False)
-		{
-			return false;
-		}
-		else // result == l_Undef
-		{
-			//placeholder
-		}
+		return SolveAssumptions() == l_True;
     }
 
     bool CarSolver::SolveWithAssumption(std::vector<int>& assumption, int frameLevel)
     {
 		m_assumptions.clear();
 		m_assumptions.push(GetLit(GetFrameFlag(frameLevel)));
+		int level = GetStepLevel();
+		m_assumptionLevel = m_isForward ? level + 1 : level;
 		for(auto it = assumption.begin(); it != assumption.end(); ++it)
 		{
-			m_assumptions.push(GetLit(*it));
-		}
-		lbool result = solveLimited(m_assumptions);
-		if (result == l_True)
-		{
-			return true;
+			m_assumptions.push(GetLit(m_model->GetPrime(*it, level)));
 		}
-		else if(result == l_False)
+		return SolveAssumptions() == l_True;
+    }
+
+    bool CarSolver::SolveWithAssumptionUnroll(std::vector<int>& assumption, int frameLevel)
+    {
+		//the state is put on the far end of the unrolled transitions, k steps away from the frame
+		m_assumptions.clear();
+		m_assumptions.push(GetLit(GetFrameFlag(frameLevel)));
+		for (int flag : m_unrollFlags)
 		{
-			return false;
+			m_assumptions.push(GetLit(flag));
 		}
-		else // result == l_Undef
+		int level = m_isForward ? m_unroll - 1 : 0;
+		m_assumptionLevel = m_isForward ? m_unroll : 0;
+		for(auto it = assumption.begin(); it != assumption.end(); ++it)
 		{
-			//placeholder
+			m_assumptions.push(GetLit(m_model->GetPrime(*it, level)));
 		}
+		return SolveAssumptions() == l_True;
     }
 
 	void CarSolver::AddClause(const std::vector<int>& clause)
@@ -80,11 +65,30 @@ namespace  car
         {
             literals.push(GetLit(clause[i]));
         }
+        if (m_trace != nullptr) TraceClause(literals);
         bool result = addClause(literals);
         assert (result != false);
     }
 
-	void CarSolver::AddUnsatisfiableCore(const std::vector<int>& clause, int frameLevel)
+	void CarSolver::AddClauses(const Cnf& cnf, int begin, int end, int shift)
+	{
+		//all variables at once, and one buffer for every clause
+		while (nVars() < cnf.GetMaxVar() + shift) newVar();
+		vec<Lit> literals;
+		for (int i = begin; i < end; ++i)
+		{
+			Lemma clause = cnf[i];
+			literals.clear();
+			for (int lit : clause)
+			{
+				literals.push(lit > 0 ? mkLit(lit + shift - 1) : ~mkLit(-lit + shift - 1));
+			}
+			if (m_trace != nullptr) TraceClause(literals);
+			addClause_(literals);
+		}
+	}
+
+	void CarSolver::AddUnsatisfiableCore(const Lemma& clause, int frameLevel)
 	{
 		int flag = GetFrameFlag(frameLevel);
 		vec<Lit> literals;
@@ -100,10 +104,11 @@ namespace  car
 		{
 			for (int i = 0; i < clause.size(); ++i)
 			{
-				literals.push(GetLit(-m_model->GetPrime(clause[i])));
+				literals.push(GetLit(-m_model->GetPrime(clause[i], m_unroll)));
 			}
 		}
 		
+        if (m_trace != nullptr) TraceClause(literals);
         bool result = addClause(literals);
         if (!result)
         {
@@ -115,65 +120,41 @@ namespace  car
     std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > > CarSolver::GetAssignment(std::ofstream& out)
 	{
 		out<<"GetAssignment:"<<std::endl;
-		assert(m_model->GetNumInputs() < nVars());
-		std::shared_ptr<std::vector<int> > inputs(new std::vector<int>());
-		std::shared_ptr<std::vector<int> > latches(new std::vector<int>());
-		inputs->reserve(m_model->GetNumInputs());
-		latches->reserve(m_model->GetNumLatches());
-		for (int i = 0; i <m_model->GetNumInputs(); ++i)
-		{
-			if (model[i] == l_True)
-			{
-				inputs->emplace_back(i+1);
-			}
-			else if (model[i] == l_False)
-			{
-				inputs->emplace_back(-i-1);
-			}
-		}
-		for (int i = m_model->GetNumInputs(), end = m_model->GetNumInputs() + m_model->GetNumLatches(); i < end; ++i)
-		{
-			if (m_isForward)
-			{
-				if (model[i] == l_True)
-				{
-					latches->emplace_back(i+1);
-				}
-				else if (model[i] == l_False)
-				{
-					latches->emplace_back(-i-1);
-				}
-			}
-			else
-			{
-				int p = m_model->GetPrime(i+1);
-				lbool val = model[abs(p)-1];
-				if ((val == l_True && p > 0) || (val == l_False && p < 0))
-				{
-					latches->emplace_back(i+1);
-				}
-				else
-				{
-					latches->emplace_back(-i-1);
-				}
-			}
-			
-		}
+		std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > > pair = GetAssignment();
 		//
-		for (auto it = inputs->begin(); it != inputs->end(); ++it)
+		for (auto it = pair.first->begin(); it != pair.first->end(); ++it)
 		{
 			out<<*it<<" ";
 		}
-		for (auto it = latches->begin(); it != latches->end(); ++it)
+		for (auto it = pair.second->begin(); it != pair.second->end(); ++it)
 		{
 			out<<*it<<" ";
 		}
 		out<<std::endl;
 
 		//
-		return std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > >(inputs, latches);
+		return pair;
 	}
+
 	std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > > CarSolver::GetAssignment()
+	{
+		return GetStepAssignment(m_isForward ? std::max(m_assumptionLevel - 1, 0) : m_assumptionLevel);
+	}
+
+	std::vector<std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > > > CarSolver::GetUnrollAssignment()
+	{
+		//ordered by the distance to the state of the query, 
+		//i.e. successors in backward mode and predecessors in forward mode
+		std::vector<std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > > > res;
+		res.reserve(m_unroll);
+		for (int i = 0; i < m_unroll; ++i)
+		{
+			res.push_back(GetStepAssignment(m_isForward ? m_unroll - 1 - i : i));
+		}
+		return res;
+	}
+
+	std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > > CarSolver::GetStepAssignment(int level)
 	{
 		assert(m_model->GetNumInputs() < nVars());
 		std::shared_ptr<std::vector<int> > inputs(new std::vector<int>());
@@ -182,42 +163,33 @@ namespace  car
 		latches->reserve(m_model->GetNumLatches());
 		for (int i = 0; i <m_model->GetNumInputs(); ++i)
 		{
-			if (model[i] == l_True)
+			lbool val = model[m_model->GetPrime(i+1, level)-1];
+			if (val == l_True)
 			{
 				inputs->emplace_back(i+1);
 			}
-			else if (model[i] == l_False)
+			else if (val == l_False)
 			{
 				inputs->emplace_back(-i-1);
 			}
 		}
+		//the predecessor (forward) is on the step itself, the successor (backward) one level after
+		int latchLevel = m_isForward ? level : level + 1;
 		for (int i = m_model->GetNumInputs(), end = m_model->GetNumInputs() + m_model->GetNumLatches(); i < end; ++i)
 		{
-			if (m_isForward)
+			if (!m_model->IsInCone(i+1))
 			{
-				if (model[i] == l_True)
-				{
-					latches->emplace_back(i+1);
-				}
-				else if (model[i] == l_False)
-				{
-					latches->emplace_back(-i-1);
-				}
+				continue;
+			}
+			lbool val = model[m_model->GetPrime(i+1, latchLevel)-1];
+			if (val == l_True)
+			{
+				latches->emplace_back(i+1);
 			}
 			else
 			{
-				int p = m_model->GetPrime(i+1);
-				lbool val = model[abs(p)-1];
-				if ((val == l_True && p > 0) || (val == l_False && p < 0))
-				{
-					latches->emplace_back(i+1);
-				}
-				else
-				{
-					latches->emplace_back(-i-1);
-				}
+				latches->emplace_back(-i-1);
 			}
-			
 		}
 		return std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > >(inputs, latches);
 	}
@@ -230,7 +202,7 @@ namespace  car
 		int val;
 		for (int i = 0; i < conflict.size(); ++i)
 		{
-			val = -GetLiteralId(conflict[i]);
+			val = m_model->GetPrevious(-GetLiteralId(conflict[i]), m_assumptionLevel);
 			if (m_model->IsLatch(val) && val != badId)
 			{
 				uc->emplace_back(val);
@@ -249,38 +221,14 @@ namespace  car
 		//need get MUC from conflict
 		if (m_extractMUC) ExtractMnimalUnsatisfiableCore(muc);
 		
+		//map the assumption literals back to latches
 		int val;
-		if (m_isForward)
-		{
-			for (int i = 0; i < muc->size(); ++i)
-			{
-				val = muc->at(i);
- 				std::vector<int> ids = m_model->GetPrevious(val);
-				if (val > 0)
-				{
- 					for(auto x: ids)
-					{
-						uc->push_back(x);
-					}
-				}
-				else
-				{
-					for(auto x:ids)
-					{
-						uc->push_back(-x);
-					}  
-				}
-			}
-		}
-		else
+		for (int i = 0; i < muc->size(); ++i)
 		{
-			for (int i = 0; i < muc->size(); ++i)
+			val = m_model->GetPrevious(muc->at(i), m_assumptionLevel);
+			if (m_model->IsLatch(val))
 			{
-				val = muc->at(i);
-				if (m_model->IsLatch(val))
-				{
-					uc->emplace_back(val);
-				}
+				uc->emplace_back(val);
 			}
 		}
 		
@@ -325,60 +273,92 @@ namespace  car
 
 	void  CarSolver::ExtractMnimalUnsatisfiableCore(std::shared_ptr<std::vector<int> > muc)
 	{
-		/****************************************
-		Description:  Extract a MUC from current UC (the confilict returned by SAT solver).
-					  The methodology is to drop literals in UC if droping it remains UNSAT.
-
-		Input:        a pointer of current conflict. Also is the output.                   
-		*****************************************/ 
-		std::shared_ptr<std::vector<int> > remainedMuc(new std::vector<int>());
-
-		ClearAssumption();                    
-		UpdateAssumption(muc);           
-		int longFlag = (muc->size() < 216) ? muc->size() : 0;
-		while(m_assumptions.size()>0 && longFlag>0)
-		{
-			longFlag--;
-			int popElement;
-			std::shared_ptr<std::vector<int> > tempAssumption(new std::vector<int>());
-			for(int i=0; i < m_assumptions.size(); i++)
-			{
-				if(i == 0) popElement = GetLiteralId(m_assumptions[i]);
-				else tempAssumption->push_back(GetLiteralId(m_assumptions[i]));
-			}
-			ClearAssumption();                    
-			UpdateAssumption(tempAssumption);
-			UpdateAssumption(remainedMuc);    //merge muc core with assumption
+		//recursive binary partitioning (QuickXplain): the second half is minimized with the first one kept,
+		//then the first half with what is left of the second one. a part that is not needed at all costs one query,
+		//and that UNSAT answer cuts the other half down to its failed assumptions.
+		//a query beyond the budget, or one that gives up, keeps its part as it is
+		std::vector<Lit> kept, core;
+		core.reserve(muc->size());
+		for (int i = 0; i < muc->size(); ++i)
+		{
+			core.push_back(GetLit(muc->at(i)));
+		}
+		m_mucQueries = 0;
+		MinimizeCore(kept, false, core);
+		muc->clear();
+		for (int i = 0; i < core.size(); ++i)
+		{
+			muc->push_back(GetLiteralId(core[i]));
+		}
+		//the core still answers the query it came from
+		m_lastResult = SolveResult::Unsat;
+	}
 
-			lbool result = solveLimited(m_assumptions);;
-			
-			for(int i=0;i<remainedMuc->size();i++)
-			{
-				m_assumptions.pop();       //remove mus core from assumption_
-			}
-			
-			if(result == l_True)                      //if sat,then the element being poped is a transition clause
-			{
-				remainedMuc->push_back(popElement);         //aad transition clause into mus core
-			}
-			else if (result == l_False)
-			{
-				std::shared_ptr<std::vector<int> > innerUc = GetInnerUnsatisfiableCore();
-				ClearAssumption();
-				for(int i=0;i<innerUc->size();i++)
-				{
-					if( std::find(remainedMuc->begin(),remainedMuc->end(),innerUc->at(i)) == remainedMuc->end())
-					{
-						m_assumptions.push(GetLit(innerUc->at(i)));   //update the assumption_ according to new reason
-					}
-				}
-			}
-			else
-			{
-				//undefind SAT result
-			}
+	bool CarSolver::MinimizeCore(std::vector<Lit>& kept, bool checkKept, std::vector<Lit>& candidates)
+	{
+		if (checkKept && IsUnsatWith(kept, candidates.end(), candidates.end()))
+		{
+			candidates.clear();
+			return true;
+		}
+		if (candidates.size() <= 1)
+		{
+			return false;
+		}
+		auto middle = candidates.begin() + candidates.size()/2;
+		std::vector<Lit> first(candidates.begin(), middle), second(middle, candidates.end());
+		int numKept = kept.size();
+		kept.insert(kept.end(), first.begin(), first.end());
+		if (MinimizeCore(kept, true, second))
+		{
+			//the kept literals and the first half are UNSAT by themselves, the conflict tells which of the first half count
+			KeepFailed(first);
+		}
+		kept.resize(numKept);
+		kept.insert(kept.end(), second.begin(), second.end());
+		MinimizeCore(kept, !second.empty(), first);
+		kept.resize(numKept);
+		candidates.swap(first);
+		candidates.insert(candidates.end(), second.begin(), second.end());
+		return false;
+	}
+
+	bool CarSolver::IsUnsatWith(const std::vector<Lit>& kept, std::vector<Lit>::iterator begin, std::vector<Lit>::iterator end)
+	{
+		if (m_mucBudget >= 0 && m_mucQueries >= m_mucBudget)
+		{
+			return false;
+		}
+		++m_mucQueries;
+		m_assumptions.clear();
+		for (int i = 0; i < kept.size(); ++i)
+		{
+			m_assumptions.push(kept[i]);
+		}
+		for (auto it = begin; it != end; ++it)
+		{
+			m_assumptions.push(*it);
+		}
+		return SolveAssumptions() == l_False;
+	}
+
+	void CarSolver::KeepFailed(std::vector<Lit>& candidates)
+	{
+		//the conflict holds the negations of the failed assumptions
+		if (m_failed.size() < nVars())
+		{
+			m_failed.resize(nVars(), false);
+		}
+		for (int i = 0; i < conflict.size(); ++i)
+		{
+			m_failed[var(conflict[i])] = true;
+		}
+		auto it = std::remove_if(candidates.begin(), candidates.end(), [this](Lit l) {return !m_failed[var(l)];});
+		candidates.erase(it, candidates.end());
+		for (int i = 0; i < conflict.size(); ++i)
+		{
+			m_failed[var(conflict[i])] = false;
 		}
-		if (! remainedMuc->empty()) muc = remainedMuc;
 	}
 
 	void CarSolver::shrinkToInputs(std::shared_ptr<std::vector<int> > assignment)
@@ -398,61 +378,51 @@ namespace  car
 	}
 
 
-	void CarSolver::AddNewFrame(const std::vector<std::shared_ptr<std::vector<int> > >& frame, int frameLevel)
+	void CarSolver::AddNewFrame(const FrameView& frame, int frameLevel)
 	{
  		for (int i = 0; i < frame.size(); ++i)
 		{
-			AddUnsatisfiableCore(*frame[i], frameLevel);
+			AddUnsatisfiableCore(frame[i], frameLevel);
 		}
 	}
 
     bool CarSolver::SolveWithAssumptionAndBad(std::vector<int>& assumption, int badId)
 	{
+		//on the level of the one-step query, whose copy of T is the one that always holds
 		m_assumptions.clear();
-		m_assumptions.push(GetLit(badId));
+		m_assumptionLevel = GetStepLevel();
+		m_assumptions.push(GetLit(m_model->GetPrime(badId, m_assumptionLevel)));
 		for(auto it = assumption.begin(); it != assumption.end(); ++it)
 		{
-			m_assumptions.push(GetLit(*it));
-		}
-		lbool result = solveLimited(m_assumptions);
-		if (result == l_True)
-		{
-			return true;
-		}
-		else if(result == l_False)
-		{
-			return false;
-		}
-		else // result == l_Undef
-		{
-			//placeholder
+			m_assumptions.push(GetLit(m_model->GetPrime(*it, m_assumptionLevel)));
 		}
+		return SolveAssumptions() == l_True;
 	}
 
-	inline void CarSolver::AddConstraintOr(const std::vector<std::shared_ptr<std::vector<int> > > frame)
+	inline void CarSolver::AddConstraintOr(const FrameView& frame)
 	{
 		std::vector<int> clause;
 		for (int i = 0; i < frame.size(); ++i)
 		{
 			int flag = GetNewVar();
 			clause.push_back(flag);
-			for (int j = 0; j < frame[i]->size(); ++j)
+			for (int j = 0; j < frame[i].size(); ++j)
 			{
-				AddClause(std::vector<int> {-flag, (*frame[i])[j]});
+				AddClause(std::vector<int> {-flag, frame[i][j]});
 			}
 		}
 		AddClause(clause);
 	}
 
-	inline void CarSolver::AddConstraintAnd(const std::vector<std::shared_ptr<std::vector<int> > > frame)
+	inline void CarSolver::AddConstraintAnd(const FrameView& frame)
 	{
 		int flag = GetNewVar();
 		for (int i = 0; i < frame.size(); ++i)
 		{
 			std::vector<int> clause;
-			for (int j = 0; j < frame[i]->size(); ++j)
+			for (int j = 0; j < frame[i].size(); ++j)
 			{
-				clause.push_back(-(*frame[i])[j]);
+				clause.push_back(-frame[i][j]);
 			}
 			clause.push_back(-flag);
 			AddClause(clause);
@@ -463,13 +433,76 @@ namespace  car
 	inline void CarSolver::FlipLastConstrain()
 	{
 		Lit lit = m_assumptions.last();
-		m_assumptions.pop();
+		PopAssumption();
 		m_assumptions.push(~lit);
 	}
 
 #pragma region private
 
 
+	lbool CarSolver::SolveAssumptions()
+	{
+		auto begin = m_trace == nullptr ? std::chrono::steady_clock::time_point() : std::chrono::steady_clock::now();
+		lbool result = SolveBudgeted();
+		m_lastResult = result == l_True ? SolveResult::Sat : (result == l_False ? SolveResult::Unsat : SolveResult::Unknown);
+		if (m_trace == nullptr)
+		{
+			return result;
+		}
+		uint64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+		std::vector<int> assumption;
+		assumption.reserve(m_assumptions.size());
+		for (int i = 0; i < m_assumptions.size(); ++i)
+		{
+			assumption.push_back(GetLiteralId(m_assumptions[i]));
+		}
+		m_trace->AddSolve(assumption.begin(), assumption.end(), static_cast<SatTrace::Result>(m_lastResult), micros);
+		return result;
+	}
+
+	lbool CarSolver::SolveBudgeted()
+	{
+		//minisat only checks its budgets during the search, so a deadline or a stop is checked between slices of conflicts
+		const int64_t slice = 10000;
+		int64_t conflictLimit = m_conflictBudget < 0 ? -1 : (int64_t)conflicts + m_conflictBudget;
+		propagation_budget = m_propagationBudget < 0 ? -1 : (int64_t)propagations + m_propagationBudget;
+		while (true)
+		{
+			if (ShouldGiveUp())
+			{
+				return l_Undef;
+			}
+			conflict_budget = conflictLimit;
+			if (HasStopCondition())
+			{
+				int64_t sliceEnd = (int64_t)conflicts + slice;
+				conflict_budget = conflictLimit < 0 ? sliceEnd : std::min(conflictLimit, sliceEnd);
+			}
+			lbool result = solve_();
+			if (result != l_Undef || !HasStopCondition() || asynch_interrupt)
+			{
+				return result;
+			}
+			bool outOfConflicts = conflictLimit >= 0 && (int64_t)conflicts >= conflictLimit;
+			bool outOfPropagations = propagation_budget >= 0 && (int64_t)propagations >= propagation_budget;
+			if (outOfConflicts || outOfPropagations)
+			{
+				return l_Undef;
+			}
+		}
+	}
+
+	void CarSolver::TraceClause(const vec<Lit>& literals)
+	{
+		std::vector<int> clause;
+		clause.reserve(literals.size());
+		for (int i = 0; i < literals.size(); ++i)
+		{
+			clause.push_back(GetLiteralId(literals[i]));
+		}
+		m_trace->AddClause(clause.begin(), clause.end());
+	}
+
 	inline int CarSolver::GetFrameFlag(int frameLevel)
 	{
 		if (frameLevel < 0)
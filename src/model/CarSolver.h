@@ -17,30 +17,44 @@ public:
 	~CarSolver();
   std::shared_ptr<std::vector<int> > GetUnsatisfiableCoreFromBad(int badId) override;
 	void AddClause(const std::vector<int>& clause) override;
-	void AddUnsatisfiableCore(const std::vector<int>& clause, int frameLevel) override;
+	void AddClauses(const Cnf& cnf, int begin, int end, int shift) override;
+	void AddUnsatisfiableCore(const Lemma& clause, int frameLevel) override;
 	std::shared_ptr<std::vector<int> > GetUnsatisfiableCore() override;
 	std::shared_ptr<std::vector<int> > GetInnerUnsatisfiableCore();
 	void UpdateAssumption(std::shared_ptr<std::vector<int> > newAssumption);
 	void  ExtractMnimalUnsatisfiableCore(std::shared_ptr<std::vector<int> > muc) override;
 	std::shared_ptr<std::vector<int> > GetParialStateUnsatisfiableCore() override;
 	void shrinkToInputs(std::shared_ptr<std::vector<int> > assignment) override;
-	void AddNewFrame(const std::vector<std::shared_ptr<std::vector<int> > >& frame, int frameLevel) override;
+	void AddNewFrame(const FrameView& frame, int frameLevel) override;
 	bool SolveWithAssumptionAndBad(std::vector<int>& assumption, int badId) override;
 	bool SolveWithAssumption() override;
 	bool SolveWithAssumption(std::vector<int>& assumption) override;
 	inline void AddAssumption(int id) override {m_assumptions.push(GetLit(id));}
+	inline void PopAssumption() override {m_assumptions.pop();}
 	bool SolveWithAssumption(std::vector<int>& assumption, int frameLevel) override;
+	bool SolveWithAssumptionUnroll(std::vector<int>& assumption, int frameLevel) override;
 
 	std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > > GetAssignment(std::ofstream& out) override;
 
 	std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > > GetAssignment() override;
 
-	inline void AddConstraintOr(const std::vector<std::shared_ptr<std::vector<int> > > frame);
-	inline void AddConstraintAnd(const std::vector<std::shared_ptr<std::vector<int> > > frame);
+	std::vector<std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > > > GetUnrollAssignment() override;
+
+	inline void AddConstraintOr(const FrameView& frame);
+	inline void AddConstraintAnd(const FrameView& frame);
 	inline void FlipLastConstrain();
-	inline void ClearAssumption () {m_assumptions.clear ();}
+	inline void ClearAssumption () override {m_assumptions.clear ();}
+
+	inline void SetBudget(int64_t conflicts, int64_t propagations) override
+	{
+		m_conflictBudget = conflicts;
+		m_propagationBudget = propagations;
+	}
+	inline void SetMucBudget(int queries) override {m_mucBudget = queries;}
+	inline void Interrupt() override {interrupt();}
+	inline void ClearInterrupt() override {clearInterrupt();}
 
-	std::shared_ptr<std::vector<int> > GetModel()
+	std::shared_ptr<std::vector<int> > GetModel() override
 	{
 		std::shared_ptr<std::vector<int> > res(new std::vector<int>());
 		res->resize(nVars (), 0);
@@ -63,6 +77,14 @@ protected:
 	}
     inline int GetLiteralId(const Lit &l);
 	inline int GetFrameFlag(int frameLevel);
+	std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > > GetStepAssignment(int level);
+
+	///
+	//the one-step query uses the last copy of T in backward mode and the first copy in forward mode,
+	//so frame lemmas always live on a single level: level m_unroll (backward) or level 0 (forward).
+	//the other copies are off for it (m_unrollFlags)
+	///
+	inline int GetStepLevel() {return m_isForward ? 0 : m_unroll - 1;}
 
 	inline Lit GetLit(int id)
 	{
@@ -77,12 +99,34 @@ protected:
 
 	inline int GetNewVar() override {return m_maxFlag++;}
 
+	//solves under m_assumptions as they are, solveLimited would copy them into the solver first
+	lbool SolveAssumptions();
+	//solve_() within the budgets and the deadline
+	lbool SolveBudgeted();
+
+	void TraceClause(const vec<Lit>& literals);
+
+	//shrinks the candidates to a minimal part that is still UNSAT together with the kept literals.
+	//with checkKept, true iff the kept literals alone are UNSAT (the candidates are dropped and the conflict is theirs)
+	bool MinimizeCore(std::vector<Lit>& kept, bool checkKept, std::vector<Lit>& candidates);
+	bool IsUnsatWith(const std::vector<Lit>& kept, std::vector<Lit>::iterator begin, std::vector<Lit>::iterator end);
+	//drops the candidates that are not among the failed assumptions of the last query
+	void KeepFailed(std::vector<Lit>& candidates);
+
 	bool m_isForward = false;
 	bool m_extractMUC = false;
+	int m_unroll = 1;
+	std::vector<int> m_unrollFlags;//of the copies of T only the unrolled query uses
+	int m_assumptionLevel = 0; //the level the latches of the last assumption are put on
 	int m_maxFlag;
+	int64_t m_conflictBudget = -1;
+	int64_t m_propagationBudget = -1;
+	int m_mucBudget = -1;
+	int m_mucQueries = 0;//spent by the running core minimization
+	std::vector<bool> m_failed;//by variable, only set inside KeepFailed
 	std::shared_ptr<AigerModel> m_model;
 	std::vector<int> m_frameFlags;
-	vec<Lit> m_assumptions;
+	vec<Lit>& m_assumptions;//the solver's own assumption vector, built in place and kept across queries
 	
 };
 
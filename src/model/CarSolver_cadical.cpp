@@ -1,14 +1,18 @@
 #include "CarSolver_cadical.h"
 #include <algorithm>
+#include <chrono>
+#include <climits>
 
 namespace  car
 {
-	CarSolver_cadical::CarSolver_cadical() {
+	CarSolver_cadical::CarSolver_cadical(): m_interrupted(false) {
     cadical_solver = new CaDiCaL::Solver;
+    cadical_solver->connect_terminator(this);
   }
 
 	CarSolver_cadical::~CarSolver_cadical()
 	{
+		cadical_solver->disconnect_terminator();
 		delete cadical_solver;
 	}
 
@@ -22,22 +26,52 @@ namespace  car
 	bool CarSolver_cadical::SolveWithAssumption()
 	{
     addAssumptionsToSolver();
+    if (m_conflictBudget >= 0){
+      //the limit only holds for the next solve
+      cadical_solver->limit("conflicts", (int)std::min<int64_t>(m_conflictBudget, INT_MAX));
+    }
+    auto begin = std::chrono::steady_clock::now();
     int res = cadical_solver->solve();
-    if (res == 10){
-      return true;
-		}else if(res == 20){
-      return false;
-    }else{
-      //placeholder
+    m_lastResult = res == 10 ? SolveResult::Sat : (res == 20 ? SolveResult::Unsat : SolveResult::Unknown);
+    if (m_trace != nullptr){
+      uint64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+      m_trace->AddSolve(assumptions.begin(), assumptions.end(), static_cast<SatTrace::Result>(m_lastResult), micros);
     }
+    return res == 10;
 	}
 
+  bool CarSolver_cadical::SolveWithAssumption(std::vector<int>& assumption)
+  {
+    assumptions.clear();
+    assumptions.insert(assumptions.end(), assumption.begin(), assumption.end());
+    if (SolveWithAssumption()) return true;
+		else return false;
+  }
+
   bool CarSolver_cadical::SolveWithAssumption(std::vector<int>& assumption, int frameLevel)
   {
     assumptions.clear();
     AddAssumption(GetFrameFlag(frameLevel));
+    int level = GetStepLevel();
+    m_assumptionLevel = m_isForward ? level + 1 : level;
     for(int assu : assumption){
-      assumptions.push_back(assu);
+      assumptions.push_back(m_model->GetPrime(assu, level));
+    }
+    if (SolveWithAssumption()) return true;
+		else return false;
+  }
+
+  bool CarSolver_cadical::SolveWithAssumptionUnroll(std::vector<int>& assumption, int frameLevel)
+  {
+    assumptions.clear();
+    AddAssumption(GetFrameFlag(frameLevel));
+    for (int flag : m_unrollFlags){
+      AddAssumption(flag);
+    }
+    int level = m_isForward ? m_unroll - 1 : 0;
+    m_assumptionLevel = m_isForward ? m_unroll : 0;
+    for(int assu : assumption){
+      assumptions.push_back(m_model->GetPrime(assu, level));
     }
     if (SolveWithAssumption()) return true;
 		else return false;
@@ -46,6 +80,7 @@ namespace  car
 
 	void CarSolver_cadical::AddClause(const std::vector<int>& clause)
   {
+    if (m_trace != nullptr) m_trace->AddClause(clause.begin(), clause.end());
     for (int lit : clause){
       cadical_solver->add(lit);
     }
@@ -53,69 +88,84 @@ namespace  car
   }
 
 
-	void CarSolver_cadical::AddUnsatisfiableCore(const std::vector<int>& clause, int frameLevel)
+	void CarSolver_cadical::AddClauses(const Cnf& cnf, int begin, int end, int shift)
+	{
+    cadical_solver->reserve(cnf.GetMaxVar() + shift);
+    std::vector<int> shifted;
+    for (int i = begin; i < end; ++i)
+    {
+      Lemma clause = cnf[i];
+      if (m_trace != nullptr)
+      {
+        shifted.clear();
+        for (int lit : clause) shifted.push_back(lit > 0 ? lit + shift : lit - shift);
+        m_trace->AddClause(shifted.begin(), shifted.end());
+      }
+      for (int lit : clause){
+        cadical_solver->add(lit > 0 ? lit + shift : lit - shift);
+      }
+      cadical_solver->add(0);
+    }
+	}
+
+
+	void CarSolver_cadical::AddUnsatisfiableCore(const Lemma& clause, int frameLevel)
 	{
     int flag = GetFrameFlag(frameLevel);
-		cadical_solver->add(-flag);
+    std::vector<int> literals;
+    literals.reserve(clause.size() + 1);
+		literals.push_back(-flag);
     if (m_isForward){
       for (int lit : clause){
-        cadical_solver->add(-lit);
+        literals.push_back(-lit);
       }
     }else{
       for (int lit : clause){
-        cadical_solver->add(-m_model->GetPrime(lit));
+        literals.push_back(-m_model->GetPrime(lit, m_unroll));
       }
     }
-    cadical_solver->add(0);
+    AddClause(literals);
 	}
 
 
   std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > > CarSolver_cadical::GetAssignment(std::ofstream& out)
 	{
 		out<<"GetAssignment:"<<std::endl;
-    int model_inputs_num = m_model->GetNumInputs();
-    int model_latches_num = m_model->GetNumLatches();
-		assert(model_inputs_num < cadical_solver->vars());
-		std::shared_ptr<std::vector<int>> inputs(new std::vector<int>());
-		std::shared_ptr<std::vector<int>> latches(new std::vector<int>());
-		inputs->reserve(model_inputs_num);
-		latches->reserve(model_latches_num);
-
-		for (int i = 0; i < model_inputs_num; ++i){
-      if (cadical_solver->val(i+1)>0) inputs->emplace_back(i+1);
-      else inputs->emplace_back(-i-1);
-		}
-		for (int i = model_inputs_num, end = model_inputs_num + model_latches_num; i < end; ++i)
-		{
-			if (m_isForward)
-			{
-        if (cadical_solver->val(i+1)>0) latches->emplace_back(i+1);
-        else latches->emplace_back(-i-1);
-			}
-			else
-			{
-				int p = m_model->GetPrime(i+1);
-        int val = cadical_solver->val(abs(p));
-        if ((val>0 && p>0) || (val<0 && p<0)) latches->emplace_back(i+1);
-        else latches->emplace_back(-i-1);
-			}
-		}
+		std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > > pair = GetAssignment();
 		//
-		for (auto it = inputs->begin(); it != inputs->end(); ++it)
+		for (auto it = pair.first->begin(); it != pair.first->end(); ++it)
 		{
 			out<<*it<<" ";
 		}
-		for (auto it = latches->begin(); it != latches->end(); ++it)
+		for (auto it = pair.second->begin(); it != pair.second->end(); ++it)
 		{
 			out<<*it<<" ";
 		}
 		out<<std::endl;
 
-		return std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > >(inputs, latches);
+		return pair;
 	}
 
 
 	std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > > CarSolver_cadical::GetAssignment()
+	{
+		return GetStepAssignment(m_isForward ? std::max(m_assumptionLevel - 1, 0) : m_assumptionLevel);
+	}
+
+
+	std::vector<std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > > > CarSolver_cadical::GetUnrollAssignment()
+	{
+		std::vector<std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > > > res;
+		res.reserve(m_unroll);
+		for (int i = 0; i < m_unroll; ++i)
+		{
+			res.push_back(GetStepAssignment(m_isForward ? m_unroll - 1 - i : i));
+		}
+		return res;
+	}
+
+
+	std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > > CarSolver_cadical::GetStepAssignment(int level)
 	{
 		int model_inputs_num = m_model->GetNumInputs();
     int model_latches_num = m_model->GetNumLatches();
@@ -126,23 +176,15 @@ namespace  car
 		latches->reserve(model_latches_num);
 
 		for (int i = 0; i < model_inputs_num; ++i){
-      if (cadical_solver->val(i+1)>0) inputs->emplace_back(i+1);
+      if (cadical_solver->val(m_model->GetPrime(i+1, level))>0) inputs->emplace_back(i+1);
       else inputs->emplace_back(-i-1);
 		}
+		int latchLevel = m_isForward ? level : level + 1;
 		for (int i = model_inputs_num, end = model_inputs_num + model_latches_num; i < end; ++i)
 		{
-			if (m_isForward)
-			{
-        if (cadical_solver->val(i+1)>0) latches->emplace_back(i+1);
-        else latches->emplace_back(-i-1);
-			}
-			else
-			{
-				int p = m_model->GetPrime(i+1);
-        int val = cadical_solver->val(abs(p));
-        if ((val>0 && p>0) || (val<0 && p<0)) latches->emplace_back(i+1);
-        else latches->emplace_back(-i-1);
-			}
+      if (!m_model->IsInCone(i+1)) continue;
+      if (cadical_solver->val(m_model->GetPrime(i+1, latchLevel))>0) latches->emplace_back(i+1);
+      else latches->emplace_back(-i-1);
 		}
 		return std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > >(inputs, latches);
 	}
@@ -156,7 +198,7 @@ namespace  car
 		int val;
 		for (int i = 0; i < conflicts.size(); ++i)
 		{
-			val = conflicts[i];
+			val = m_model->GetPrevious(conflicts[i], m_assumptionLevel);
 			if (m_model->IsLatch(val) && val != badId)
 			{
 				uc->emplace_back(val);
@@ -170,90 +212,134 @@ namespace  car
 	{
 		std::shared_ptr<std::vector<int>> uc(new std::vector<int>());
     getConflicts();
+		if (m_extractMUC)
+		{
+			std::shared_ptr<std::vector<int> > muc(new std::vector<int>(conflicts));
+			ExtractMnimalUnsatisfiableCore(muc);
+			conflicts.swap(*muc);
+		}
 		uc->reserve(conflicts.size());
 		int val;
-		if (m_isForward)
+		for (int i = 0; i < conflicts.size(); ++i)
 		{
-			for (int i = 0; i < conflicts.size(); ++i)
+			val = m_model->GetPrevious(conflicts[i], m_assumptionLevel);
+			if (m_model->IsLatch(val))
 			{
-				val = conflicts[i];
- 				std::vector<int> ids = m_model->GetPrevious(val);
-				if (val > 0)
-				{
- 					for(auto x: ids)
-					{
-						uc->push_back(x);
-					}
-				}
-				else
-				{
-					for(auto x:ids)
-					{
-						uc->push_back(-x);
-					}  
-				}
+				uc->emplace_back(val);
 			}
 		}
-		else
+		
+		std::sort(uc->begin(), uc->end(), cmp);
+		return uc;
+	}
+
+	std::shared_ptr<std::vector<int> > CarSolver_cadical::GetParialStateUnsatisfiableCore()
+	{
+    getConflicts();
+		std::shared_ptr<std::vector<int> > muc(new std::vector<int>(conflicts));
+		if (m_extractMUC) ExtractMnimalUnsatisfiableCore(muc);
+		return muc;
+	}
+
+	void CarSolver_cadical::ExtractMnimalUnsatisfiableCore(std::shared_ptr<std::vector<int> > muc)
+	{
+		//drops the literals of the core one by one as long as the rest stays unsatisfiable,
+		//a failed query shrinks the core further to its own failed assumptions.
+		//the literals left when the budget runs out are kept
+		std::vector<int> core(*muc);
+		int i = 0, numQueries = 0;
+		while (i < core.size() && (m_mucBudget < 0 || numQueries++ < m_mucBudget))
 		{
-			for (int i = 0; i < conflicts.size(); ++i)
+			assumptions.clear();
+			for (int j = 0; j < core.size(); ++j)
+			{
+				if (j != i) assumptions.push_back(core[j]);
+			}
+			//a query that gave up keeps the literal, as a satisfiable one does
+			if (SolveWithAssumption() || m_lastResult == SolveResult::Unknown)
+			{
+				++i;
+				continue;
+			}
+			if (assumptions.empty())
 			{
-				val = conflicts[i];
-				if (m_model->IsLatch(val))
+				core.clear();
+				break;
+			}
+			getConflicts();
+			std::vector<int> next;
+			next.reserve(conflicts.size());
+			int nextI = 0;
+			//the failed assumptions come in the order of the assumptions
+			for (int j = 0, k = 0; j < core.size(); ++j)
+			{
+				if (j != i && k < conflicts.size() && conflicts[k] == core[j])
 				{
-					uc->emplace_back(val);
+					next.push_back(core[j]);
+					if (j < i) ++nextI;
+					++k;
 				}
 			}
+			core.swap(next);
+			i = nextI;
 		}
-		
-		std::sort(uc->begin(), uc->end(), cmp);
-		return uc;
+		muc->swap(core);
+		//the core still answers the query it came from
+		m_lastResult = SolveResult::Unsat;
+	}
+
+	void CarSolver_cadical::shrinkToInputs(std::shared_ptr<std::vector<int> > assignment)
+	{
+		auto it = std::remove_if(assignment->begin(), assignment->end(), [this](int val) {return !m_model->IsInput(val);});
+		assignment->erase(it, assignment->end());
 	}
 
 
-	void CarSolver_cadical::AddNewFrame(const std::vector<std::shared_ptr<std::vector<int> > >& frame, int frameLevel)
+	void CarSolver_cadical::AddNewFrame(const FrameView& frame, int frameLevel)
 	{
  		for (int i = 0; i < frame.size(); ++i)
 		{
-			AddUnsatisfiableCore(*frame[i], frameLevel);
+			AddUnsatisfiableCore(frame[i], frameLevel);
 		}
 	}
 
   bool CarSolver_cadical::SolveWithAssumptionAndBad(std::vector<int>& assumption, int badId)
 	{
+    //on the level of the one-step query, whose copy of T is the one that always holds
     assumptions.clear();
-    assumptions.push_back(badId);
+    m_assumptionLevel = GetStepLevel();
+    assumptions.push_back(m_model->GetPrime(badId, m_assumptionLevel));
     for (int assu : assumption){
-      assumptions.push_back(assu);
+      assumptions.push_back(m_model->GetPrime(assu, m_assumptionLevel));
     }
     if (SolveWithAssumption()) return true;
 		else return false;
 	}
 
-	inline void CarSolver_cadical::AddConstraintOr(const std::vector<std::shared_ptr<std::vector<int> > > frame)
+	inline void CarSolver_cadical::AddConstraintOr(const FrameView& frame)
 	{
 		std::vector<int> clause;
 		for (int i = 0; i < frame.size(); ++i)
 		{
 			int flag = GetNewVar();
 			clause.push_back(flag);
-			for (int j = 0; j < frame[i]->size(); ++j)
+			for (int j = 0; j < frame[i].size(); ++j)
 			{
-				AddClause(std::vector<int> {-flag, (*frame[i])[j]});
+				AddClause(std::vector<int> {-flag, frame[i][j]});
 			}
 		}
 		AddClause(clause);
 	}
 
-	inline void CarSolver_cadical::AddConstraintAnd(const std::vector<std::shared_ptr<std::vector<int> > > frame)
+	inline void CarSolver_cadical::AddConstraintAnd(const FrameView& frame)
 	{
 		int flag = GetNewVar();
 		for (int i = 0; i < frame.size(); ++i)
 		{
 			std::vector<int> clause;
-			for (int j = 0; j < frame[i]->size(); ++j)
+			for (int j = 0; j < frame[i].size(); ++j)
 			{
-				clause.push_back(-(*frame[i])[j]);
+				clause.push_back(-frame[i][j]);
 			}
 			clause.push_back(-flag);
 			AddClause(clause);
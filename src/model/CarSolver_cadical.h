@@ -6,11 +6,12 @@
 #include "AigerModel.h"
 #include <memory>
 #include <cassert>
+#include <atomic>
 
 namespace car
 {
 
-class CarSolver_cadical: public ISolver
+class CarSolver_cadical: public ISolver, public CaDiCaL::Terminator
 {
 public:
 	CarSolver_cadical();
@@ -18,23 +19,43 @@ public:
 
   std::shared_ptr<std::vector<int> > GetUnsatisfiableCoreFromBad(int badId) override;
 	void AddClause(const std::vector<int>& clause) override;
-	void AddUnsatisfiableCore(const std::vector<int>& clause, int frameLevel) override;
+	void AddClauses(const Cnf& cnf, int begin, int end, int shift) override;
+	void AddUnsatisfiableCore(const Lemma& clause, int frameLevel) override;
 	std::shared_ptr<std::vector<int> > GetUnsatisfiableCore() override;
-	void AddNewFrame(const std::vector<std::shared_ptr<std::vector<int> > >& frame, int frameLevel) override;
+	void ExtractMnimalUnsatisfiableCore(std::shared_ptr<std::vector<int> > muc) override;
+	std::shared_ptr<std::vector<int> > GetParialStateUnsatisfiableCore() override;
+	void shrinkToInputs(std::shared_ptr<std::vector<int> > assignment) override;
+	void AddNewFrame(const FrameView& frame, int frameLevel) override;
 	bool SolveWithAssumptionAndBad(std::vector<int>& assumption, int badId) override;
 	bool SolveWithAssumption() override;
+	bool SolveWithAssumption(std::vector<int>& assumption) override;
 	inline void AddAssumption(int id) override {assumptions.push_back(id);}
+	inline void PopAssumption() override {assumptions.pop_back();}
+	inline void ClearAssumption() override {assumptions.clear();}
+
+	//the cadical backend bounds conflicts only: its limit() knows conflicts and decisions but no propagations,
+	//so the propagation budget (-props) is ignored here and a query runs until its conflict budget or the deadline
+	inline void SetBudget(int64_t conflicts, int64_t /*propagations*/) override {m_conflictBudget = conflicts;}
+	inline void SetMucBudget(int queries) override {m_mucBudget = queries;}
+	inline void Interrupt() override {m_interrupted = true;}
+	inline void ClearInterrupt() override {m_interrupted = false;}
+	//polled by cadical during the search
+	inline bool terminate() override {return m_interrupted || ShouldGiveUp();}
+
 	bool SolveWithAssumption(std::vector<int>& assumption, int frameLevel) override;
+	bool SolveWithAssumptionUnroll(std::vector<int>& assumption, int frameLevel) override;
 
 	std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > > GetAssignment(std::ofstream& out) override;
 
 	std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > > GetAssignment() override;
 
-	inline void AddConstraintOr(const std::vector<std::shared_ptr<std::vector<int> > > frame);
-	inline void AddConstraintAnd(const std::vector<std::shared_ptr<std::vector<int> > > frame);
+	std::vector<std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > > > GetUnrollAssignment() override;
+
+	inline void AddConstraintOr(const FrameView& frame);
+	inline void AddConstraintAnd(const FrameView& frame);
 	inline void FlipLastConstrain();
 
-	std::shared_ptr<std::vector<int> > GetModel()
+	std::shared_ptr<std::vector<int> > GetModel() override
 	{
 		std::shared_ptr<std::vector<int>> res(new std::vector<int>());
 		res->resize(cadical_solver->vars(), 0);
@@ -62,10 +83,19 @@ protected:
 	}
   
 	inline int GetFrameFlag(int frameLevel);
-	inline int GetNewVar() {return m_maxFlag++;}
+	std::pair<std::shared_ptr<std::vector<int> >, std::shared_ptr<std::vector<int> > > GetStepAssignment(int level);
+	inline int GetStepLevel() {return m_isForward ? 0 : m_unroll - 1;}
+	inline int GetNewVar() override {return m_maxFlag++;}
 
 	bool m_isForward = false;
+	bool m_extractMUC = false;
+	int m_unroll = 1;
+	std::vector<int> m_unrollFlags;//of the copies of T only the unrolled query uses
+	int m_assumptionLevel = 0; //the level the latches of the last assumption are put on
 	int m_maxFlag;
+	int64_t m_conflictBudget = -1;
+	int m_mucBudget = -1;
+	std::atomic<bool> m_interrupted;
 	std::shared_ptr<AigerModel> m_model;
 	std::vector<int> m_frameFlags;
 	
@@ -0,0 +1,69 @@
+#ifndef CNF_H
+#define CNF_H
+
+#include <vector>
+#include <initializer_list>
+#include <cstdlib>
+#include "UcArena.h"
+
+namespace car
+{
+
+///
+//a clause list stored flat: all literals in one vector, clause i is the literals from offset i to offset i+1.
+//built once by the model and loaded by every solver in one go
+///
+class Cnf
+{
+public:
+	Cnf(): m_offsets(1, 0), m_maxVar(0) {}
+
+	void Push(const Lemma& clause)
+	{
+		m_literals.insert(m_literals.end(), clause.begin(), clause.end());
+		Close();
+	}
+
+	void Push(std::initializer_list<int> clause)
+	{
+		m_literals.insert(m_literals.end(), clause.begin(), clause.end());
+		Close();
+	}
+
+	inline Lemma operator[](int i) const {return Lemma(m_literals.data() + m_offsets[i], m_offsets[i+1] - m_offsets[i]);}
+
+	inline int size() const {return m_offsets.size() - 1;}
+
+	inline int NumLiterals() const {return m_literals.size();}
+
+	//the largest variable in the clauses, so that a solver can make room for all of them at once
+	inline int GetMaxVar() const {return m_maxVar;}
+
+	void clear()
+	{
+		std::vector<int>().swap(m_literals);
+		m_offsets.assign(1, 0);
+		m_maxVar = 0;
+	}
+
+private:
+	void Close()
+	{
+		for (int i = m_offsets.back(); i < m_literals.size(); ++i)
+		{
+			if (abs(m_literals[i]) > m_maxVar)
+			{
+				m_maxVar = abs(m_literals[i]);
+			}
+		}
+		m_offsets.push_back(m_literals.size());
+	}
+
+	std::vector<int> m_literals;
+	std::vector<int> m_offsets;
+	int m_maxVar;
+};
+
+}//namespace car
+
+#endif
@@ -0,0 +1,322 @@
+#ifndef EQUIVALENCESWEEPER_H
+#define EQUIVALENCESWEEPER_H
+
+extern "C"
+{
+#include "aiger.h"
+}
+#include "../sat/minisat/core/Solver.h"
+#include <vector>
+#include <unordered_map>
+#include <random>
+#include <cstdint>
+#include <algorithm>
+
+namespace car
+{
+
+///
+//finds the latches and gates that are equal (or opposite) to another one, or constant, in every reachable state.
+//random simulation from the initial states proposes classes of candidates, SAT refines them until
+//they hold in the initial states and are inductive: assuming every class in a state, it holds in the next one.
+//the literals are aiger literals; the class of constant false is led by literal 0.
+///
+class EquivalenceSweeper
+{
+public:
+	EquivalenceSweeper(const aiger* aig): m_aig(aig), m_numVars(aig->maxvar + 1) {}
+
+	//the literal each variable is replaced by, the positive literal of the variable itself if it stays
+	std::vector<unsigned> Sweep()
+	{
+		Simulate();
+		RefineInitial();
+		while (RefineInductive());
+
+		std::vector<unsigned> repr(m_numVars);
+		for (unsigned v = 0; v < m_numVars; ++v)
+		{
+			repr[v] = 2*v;
+		}
+		for (auto& cls : m_classes)
+		{
+			//members come in the order of variables, so the leader is defined before the others
+			for (int i = 1; i < cls.size(); ++i)
+			{
+				repr[cls[i]/2] = cls[0] ^ (cls[i] & 1);
+			}
+		}
+		return repr;
+	}
+
+private:
+	//l_True and l_False are macros over an unqualified lbool
+	typedef Minisat::lbool lbool;
+
+	//a few runs of 64 random traces each; a member is kept in the phase it has in the first trace at step 0,
+	//so that the members of a class agree on every simulated value
+	void Simulate()
+	{
+		const int runs = 4, steps = 64;
+		std::mt19937_64 random(0x5eed);
+		std::vector<uint64_t> values(m_numVars, 0), next(m_aig->num_latches);
+		for (int run = 0; run < runs; ++run)
+		{
+			for (int i = 0; i < m_aig->num_latches; ++i)
+			{
+				const aiger_symbol& latch = m_aig->latches[i];
+				values[latch.lit/2] = latch.reset == 0 ? 0 : (latch.reset == 1 ? ~0ull : random());
+			}
+			for (int step = 0; step < steps; ++step)
+			{
+				for (int i = 0; i < m_aig->num_inputs; ++i)
+				{
+					values[m_aig->inputs[i].lit/2] = random();
+				}
+				for (int i = 0; i < m_aig->num_ands; ++i)
+				{
+					const aiger_and& aa = m_aig->ands[i];
+					values[aa.lhs/2] = Value(values, aa.rhs0) & Value(values, aa.rhs1);
+				}
+				if (m_classes.empty())
+				{
+					InitClasses(values);
+				}
+				Split([&values](unsigned lit) {return Value(values, lit);});
+				for (int i = 0; i < m_aig->num_latches; ++i)
+				{
+					next[i] = Value(values, m_aig->latches[i].next);
+				}
+				for (int i = 0; i < m_aig->num_latches; ++i)
+				{
+					values[m_aig->latches[i].lit/2] = next[i];
+				}
+			}
+		}
+		m_classes.erase(std::remove_if(m_classes.begin(), m_classes.end(), 
+			[](const std::vector<unsigned>& cls) {return cls.size() < 2;}), m_classes.end());
+	}
+
+	//one class of every latch and gate. inputs are free in every step, so they are no candidates.
+	//neither is anything a constraint reads: the classes are proved under the constraints,
+	//and merging the constraint's own logic would weaken or drop it
+	void InitClasses(const std::vector<uint64_t>& values)
+	{
+		std::vector<bool> isConstrained = ConstraintCone();
+		std::vector<unsigned> candidates;
+		candidates.push_back(0);
+		for (int i = 0; i < m_aig->num_latches; ++i)
+		{
+			if (!isConstrained[m_aig->latches[i].lit/2])
+			{
+				candidates.push_back(m_aig->latches[i].lit);
+			}
+		}
+		for (int i = 0; i < m_aig->num_ands; ++i)
+		{
+			if (!isConstrained[m_aig->ands[i].lhs/2])
+			{
+				candidates.push_back(m_aig->ands[i].lhs);
+			}
+		}
+		std::sort(candidates.begin(), candidates.end());
+		for (unsigned& lit : candidates)
+		{
+			lit |= values[lit/2] & 1;
+		}
+		m_classes.push_back(candidates);
+	}
+
+	//the gates and latches in the combinational fan-in of the constraints, down to the latches and inputs
+	std::vector<bool> ConstraintCone()
+	{
+		std::vector<int> andOf(m_numVars, -1);
+		for (int i = 0; i < m_aig->num_ands; ++i)
+		{
+			andOf[m_aig->ands[i].lhs/2] = i;
+		}
+		std::vector<bool> isConstrained(m_numVars, false);
+		std::vector<unsigned> todo;
+		for (int i = 0; i < m_aig->num_constraints; ++i)
+		{
+			todo.push_back(m_aig->constraints[i].lit/2);
+		}
+		while (!todo.empty())
+		{
+			unsigned v = todo.back();
+			todo.pop_back();
+			if (v == 0 || isConstrained[v])
+			{
+				continue;
+			}
+			isConstrained[v] = true;
+			if (andOf[v] >= 0)
+			{
+				todo.push_back(m_aig->ands[andOf[v]].rhs0/2);
+				todo.push_back(m_aig->ands[andOf[v]].rhs1/2);
+			}
+		}
+		return isConstrained;
+	}
+
+	//the classes must hold in every initial state in which the constraints hold
+	void RefineInitial()
+	{
+		Minisat::Solver solver;
+		Encode(solver, 0);
+		for (int i = 0; i < m_aig->num_latches; ++i)
+		{
+			const aiger_symbol& latch = m_aig->latches[i];
+			if (latch.reset <= 1)
+			{
+				solver.addClause(GetLit(latch.lit ^ (latch.reset ^ 1), 0));
+			}
+		}
+		AddConstraints(solver);
+		Refine(solver, 0);
+	}
+
+	//assuming the classes and the constraints in a state, the classes must hold in the next state.
+	//a class split on the way weakens the assumption, so another round follows until nothing splits
+	bool RefineInductive()
+	{
+		Minisat::Solver solver;
+		Encode(solver, 0);
+		Encode(solver, 1);
+		for (int i = 0; i < m_aig->num_latches; ++i)
+		{
+			const aiger_symbol& latch = m_aig->latches[i];
+			solver.addClause(~GetLit(latch.lit, 1), GetLit(latch.next, 0));
+			solver.addClause(GetLit(latch.lit, 1), ~GetLit(latch.next, 0));
+		}
+		AddConstraints(solver);
+		for (auto& cls : m_classes)
+		{
+			for (int i = 1; i < cls.size(); ++i)
+			{
+				solver.addClause(~GetLit(cls[0], 0), GetLit(cls[i], 0));
+				solver.addClause(GetLit(cls[0], 0), ~GetLit(cls[i], 0));
+			}
+		}
+		return Refine(solver, 1);
+	}
+
+	//checks every member against the leader of its class on the frame. a model that separates them
+	//splits all the classes by its values. a member proved equal stays so for the rest of the pass,
+	//since every later model satisfies the same clauses. returns whether anything split
+	bool Refine(Minisat::Solver& solver, int frame)
+	{
+		bool isSplit = false;
+		std::vector<bool> isProved(m_numVars, false);
+		for (int c = 0; c < m_classes.size(); ++c)
+		{
+			for (int i = 1; i < m_classes[c].size();)
+			{
+				unsigned leader = m_classes[c][0], member = m_classes[c][i];
+				if (isProved[member/2])
+				{
+					++i;
+					continue;
+				}
+				Minisat::Lit differ = Minisat::mkLit(solver.newVar());
+				solver.addClause(~differ, GetLit(leader, frame), GetLit(member, frame));
+				solver.addClause(~differ, ~GetLit(leader, frame), ~GetLit(member, frame));
+				Minisat::vec<Minisat::Lit> assumptions;
+				assumptions.push(differ);
+				solver.setConfBudget(m_conflictBudget);
+				lbool result = solver.solveLimited(assumptions);
+				solver.addClause(~differ);
+				if (result == l_False)
+				{
+					isProved[member/2] = true;
+					++i;
+				}
+				else if (result == l_True)
+				{
+					Split([&solver, frame, this](unsigned lit) {return solver.modelValue(GetLit(lit, frame)) == l_True ? 1ull : 0ull;});
+					isSplit = true;
+				}
+				else
+				{
+					//undecided, the member goes on alone
+					m_classes[c].erase(m_classes[c].begin() + i);
+					isSplit = true;
+				}
+			}
+		}
+		return isSplit;
+	}
+
+	//the members of a class that differ from its leader move to new classes at the end, one per value,
+	//so the classes before them keep their places
+	template <class Valuation>
+	void Split(Valuation value)
+	{
+		std::unordered_map<uint64_t, int> groups;
+		for (int c = 0, end = m_classes.size(); c < end; ++c)
+		{
+			if (m_classes[c].size() < 2)
+			{
+				continue;
+			}
+			std::vector<unsigned> members;
+			members.swap(m_classes[c]);
+			uint64_t leaderValue = value(members[0]);
+			groups.clear();
+			for (unsigned lit : members)
+			{
+				uint64_t v = value(lit);
+				if (v == leaderValue)
+				{
+					m_classes[c].push_back(lit);
+					continue;
+				}
+				auto it = groups.emplace(v, (int)m_classes.size());
+				if (it.second)
+				{
+					m_classes.emplace_back();
+				}
+				m_classes[it.first->second].push_back(lit);
+			}
+		}
+	}
+
+	void Encode(Minisat::Solver& solver, int frame)
+	{
+		while (solver.nVars() < (frame + 1)*m_numVars)
+		{
+			solver.newVar();
+		}
+		solver.addClause(GetLit(1, frame));
+		for (int i = 0; i < m_aig->num_ands; ++i)
+		{
+			const aiger_and& aa = m_aig->ands[i];
+			Minisat::Lit g = GetLit(aa.lhs, frame), a = GetLit(aa.rhs0, frame), b = GetLit(aa.rhs1, frame);
+			solver.addClause(~g, a);
+			solver.addClause(~g, b);
+			solver.addClause(g, ~a, ~b);
+		}
+	}
+
+	void AddConstraints(Minisat::Solver& solver)
+	{
+		for (int i = 0; i < m_aig->num_constraints; ++i)
+		{
+			solver.addClause(GetLit(m_aig->constraints[i].lit, 0));
+		}
+	}
+
+	inline Minisat::Lit GetLit(unsigned lit, int frame) {return Minisat::mkLit(frame*m_numVars + lit/2, lit & 1);}
+
+	static inline uint64_t Value(const std::vector<uint64_t>& values, unsigned lit) {return (lit & 1) ? ~values[lit/2] : values[lit/2];}
+
+	const aiger* m_aig;
+	int m_numVars;
+	//proving a pair may take this many conflicts, beyond them the pair is taken as different
+	int64_t m_conflictBudget = 1000;
+	std::vector<std::vector<unsigned> > m_classes;//each one sorted by variable, the first member leads
+};
+
+}//namespace car
+
+#endif
@@ -0,0 +1,199 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <unordered_map>
+#include "UcArena.h"
+#include "WatchedFrame.h"
+
+namespace car
+{
+
+///
+//the ucs of one frame in the order they were inserted, with their watched packed form for blocking checks,
+//their literal signatures, bucketed by uc size, for subsumption checks,
+//and their hashes, summed up to a fingerprint that does not depend on the order of the ucs
+///
+class Frame
+{
+public:
+	Frame(int numInputs): m_numInputs(numInputs), m_fingerprint(0) {}
+
+	void Push(const Lemma& uc)
+	{
+		m_ucs.Push(uc);
+		m_signatures.push_back(Signature(uc));
+		m_hashes.push_back(HashLemma(uc));
+		m_fingerprint += m_hashes.back();
+		m_index.Push(uc, m_numInputs);
+		AddToBucket(m_ucs.size() - 1);
+	}
+
+	//removes in place every uc that is a superset of uc
+	void RemoveImplied(const Lemma& uc)
+	{
+		uint64_t signature = Signature(uc);
+		std::vector<bool> keep;
+		for (int size = uc.size(); size < m_buckets.size(); ++size)
+		{
+			std::vector<Entry>& bucket = m_buckets[size];
+			for (int i = 0; i < bucket.size(); ++i)
+			{
+				//one AND rejects most of the candidates
+				if ((bucket[i].signature & signature) != signature || !IsImply(m_ucs[bucket[i].pos], uc))
+				{
+					continue;
+				}
+				if (keep.empty())
+				{
+					keep.resize(m_ucs.size(), true);
+				}
+				keep[bucket[i].pos] = false;
+			}
+		}
+		if (!keep.empty())
+		{
+			Compact(keep);
+		}
+	}
+
+	bool IsBlocking(const PackedState& state)
+	{
+		return m_index.IsBlocking(state);
+	}
+
+	//is uc itself in the frame
+	bool Contains(const Lemma& uc) const
+	{
+		auto range = m_byHash.equal_range(HashLemma(uc));
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			Lemma other = m_ucs[it->second];
+			if (other.size() == uc.size() && std::equal(uc.begin(), uc.end(), other.begin()))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//is there a uc in the frame that is a subset of uc, i.e. that blocks every state uc blocks
+	bool HasSubsetOf(const Lemma& uc) const
+	{
+		if (Contains(uc))
+		{
+			return true;
+		}
+		uint64_t signature = Signature(uc);
+		for (int size = 0; size < uc.size() && size < m_buckets.size(); ++size)
+		{
+			const std::vector<Entry>& bucket = m_buckets[size];
+			for (int i = 0; i < bucket.size(); ++i)
+			{
+				if ((bucket[i].signature & ~signature) == 0 && IsImply(uc, m_ucs[bucket[i].pos]))
+				{
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	inline uint64_t GetFingerprint() const {return m_fingerprint;}
+
+	inline const UcArena& GetUcs() const {return m_ucs;}
+
+	inline int Size() const {return m_ucs.size();}
+
+	//ucs are sorted by latch
+	static bool IsImply(const Lemma& v1, const Lemma& v2) //if v2->v1
+	{
+		if (v1.size () < v2.size ())
+			return false;
+		const int* first1 = v1.begin (), *first2 = v2.begin (), *last1 = v1.end (), *last2 = v2.end ();
+		while (first2 != last2) 
+		{
+			if ( (first1 == last1) || abs (*first2) < abs (*first1) ) 
+				return false;
+			if ((*first1) == (*first2)) 
+				++ first2;
+			++ first1;
+		}
+		return true;
+	}
+
+private:
+	struct Entry
+	{
+		uint64_t signature;
+		int pos;
+	};
+
+	static inline uint64_t Signature(const Lemma& uc)
+	{
+		uint64_t res = 0;
+		for (int i = 0; i < uc.size(); ++i)
+		{
+			res |= 1ull << ((2*abs(uc[i]) + (uc[i] < 0)) & 63);
+		}
+		return res;
+	}
+
+	void AddToBucket(int pos)
+	{
+		int size = m_ucs[pos].size();
+		if (size >= m_buckets.size())
+		{
+			m_buckets.resize(size + 1);
+		}
+		m_buckets[size].push_back(Entry{m_signatures[pos], pos});
+		m_byHash.emplace(m_hashes[pos], pos);
+	}
+
+	void Compact(const std::vector<bool>& keep)
+	{
+		int j = 0;
+		for (int i = 0; i < m_signatures.size(); ++i)
+		{
+			if (keep[i])
+			{
+				m_signatures[j] = m_signatures[i];
+				m_hashes[j] = m_hashes[i];
+				++j;
+			}
+			else
+			{
+				m_fingerprint -= m_hashes[i];
+			}
+		}
+		m_signatures.resize(j);
+		m_hashes.resize(j);
+		m_ucs.RemoveIf(keep);
+		m_index.RemoveIf(keep);
+		for (int i = 0; i < m_buckets.size(); ++i)
+		{
+			m_buckets[i].clear();
+		}
+		m_byHash.clear();
+		for (int i = 0; i < m_ucs.size(); ++i)
+		{
+			AddToBucket(i);
+		}
+	}
+
+	int m_numInputs;
+	UcArena m_ucs;
+	std::vector<uint64_t> m_signatures;//m_signatures[i] has one bit per literal of m_ucs[i]
+	WatchedFrame m_index;//m_index.GetUc(i) is m_ucs[i] packed
+	std::vector<std::vector<Entry> > m_buckets;//m_buckets[n] lists the ucs with n literals
+	std::vector<uint64_t> m_hashes;//m_hashes[i] is HashLemma(m_ucs[i])
+	std::unordered_multimap<uint64_t, int> m_byHash;//from the hash of a uc to its position
+	uint64_t m_fingerprint;//the sum of m_hashes
+};
+
+}//namespace car
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef FRAMEVIEW_H
+#define FRAMEVIEW_H
+
+#include "UcArena.h"
+
+namespace car
+{
+
+///
+//a read-only view of the ucs of a frame that does not copy them, valid until the frame is next modified.
+//a frame may be kept in two parts (e.g. unpropagated and propagated ucs), the view reads the first part, then the second
+///
+class FrameView
+{
+public:
+	FrameView(): m_first(nullptr), m_second(nullptr) {}
+
+	FrameView(const UcArena& first): m_first(&first), m_second(nullptr) {}
+
+	FrameView(const UcArena& first, const UcArena& second): m_first(&first), m_second(&second) {}
+
+	inline int size() const
+	{
+		return (m_first ? m_first->size() : 0) + (m_second ? m_second->size() : 0);
+	}
+
+	inline bool empty() const {return size() == 0;}
+
+	inline Lemma operator[](int i) const
+	{
+		int firstSize = m_first ? m_first->size() : 0;
+		return i < firstSize ? (*m_first)[i] : (*m_second)[i - firstSize];
+	}
+
+	inline Lemma back() const {return (*this)[size() - 1];}
+
+private:
+	const UcArena* m_first;
+	const UcArena* m_second;
+};
+
+}//namespace car
+
+#endif
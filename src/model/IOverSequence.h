@@ -3,20 +3,29 @@
 
 #include <vector>
 #include <memory>
+#include "PackedCube.h"
+#include "FrameView.h"
 namespace car
 {
 
 class IOverSequence
 {
 public:
-    virtual void Insert(std::shared_ptr<std::vector<int> > uc, int index) = 0;
+    virtual void Insert(const std::vector<int>& uc, int index) = 0;
 	
-	virtual void GetFrame(int frameLevel, std::vector<std::shared_ptr<std::vector<int> > >& out) = 0;
+	//the view is empty if the frame does not exist yet
+	virtual FrameView GetFrame(int frameLevel) = 0;
+
+	virtual int GetFrameSize(int frameLevel) = 0;
 	
-    virtual bool IsBlockedByFrame(std::vector<int>& state, int frameLevel, bool isPartial) = 0;
+    virtual bool IsBlockedByFrame(const PackedState& state, int frameLevel) = 0;
 	
 	virtual int GetLength() = 0;
 
+	//a cheap sufficient condition for O_frameLevel being contained in O_frameLevel-1:
+	//every uc of frame frameLevel-1 is a superset of some uc of frame frameLevel
+	virtual bool IsSyntacticFixpoint(int frameLevel) = 0;
+
 	int effectiveLevel;
 	bool isForward = false;
 };
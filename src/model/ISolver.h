@@ -3,37 +3,103 @@
 
 #include <vector>
 #include "State.h"
+#include "FrameView.h"
+#include "SatTrace.h"
+#include "Cnf.h"
 #include <fstream>
 #include <memory>
+#include <chrono>
+#include <cstdint>
+#include <atomic>
 
 namespace car
 {
 
+//the outcome of a query, Unknown when it gave up: out of budget, past the deadline or interrupted.
+//the values are those of SatTrace::Result
+enum SolveResult
+{
+	Unsat = 0,
+	Sat = 1,
+	Unknown = 2
+};
+
 class ISolver
 {
 public:
 	virtual std::shared_ptr<std::vector<int> > GetUnsatisfiableCoreFromBad(int badId) = 0;
 	virtual void AddClause(const std::vector<int>& clause) = 0;
-	virtual void AddUnsatisfiableCore(const std::vector<int>& clause, int frameLevel) = 0;
+	//adds the clauses begin..end of the cnf, every variable moved up by shift (a copy of T on another level)
+	virtual void AddClauses(const Cnf& cnf, int begin, int end, int shift) = 0;
+	virtual void AddUnsatisfiableCore(const Lemma& clause, int frameLevel) = 0;
 	virtual std::shared_ptr<std::vector<int> > GetUnsatisfiableCore() = 0;
 	virtual void  ExtractMnimalUnsatisfiableCore(std::shared_ptr<std::vector<int> > muc) = 0;
 	virtual std::shared_ptr<std::vector<int> > GetParialStateUnsatisfiableCore() = 0;
 	virtual void shrinkToInputs(std::shared_ptr<std::vector<int> > assignment) = 0;
+	//the assumption is edited literal by literal and then solved by SolveWithAssumption()
 	inline virtual void AddAssumption(int id) = 0;
-	virtual void AddNewFrame(const std::vector<std::shared_ptr<std::vector<int> > >& frame, int frameLevel) = 0;
+	inline virtual void PopAssumption() = 0;
+	inline virtual void ClearAssumption() = 0;
+	virtual void AddNewFrame(const FrameView& frame, int frameLevel) = 0;
+	//the solves are true iff the query is satisfiable, GetLastResult() tells UNSAT from Unknown
 	virtual bool SolveWithAssumptionAndBad(std::vector<int>& assumption, int badId) = 0;
 	virtual bool SolveWithAssumption() = 0;
 	virtual bool SolveWithAssumption(std::vector<int>& assumption) = 0;
 	virtual bool SolveWithAssumption(std::vector<int>& assumption, int frameLevel) = 0;
+	virtual bool SolveWithAssumptionUnroll(std::vector<int>& assumption, int frameLevel) = 0;
 	virtual std::pair<std::shared_ptr<std::vector<int> > , std::shared_ptr<std::vector<int> > > GetAssignment(std::ofstream& out) = 0;
 	virtual int GetNewVar() = 0;
 	virtual std::pair<std::shared_ptr<std::vector<int> > , std::shared_ptr<std::vector<int> > > GetAssignment() = 0;
+	virtual std::vector<std::pair<std::shared_ptr<std::vector<int> > , std::shared_ptr<std::vector<int> > > > GetUnrollAssignment() = 0;
+	//the value of every variable in the last model, the i-th entry is i+1 or -(i+1) (0 if unassigned)
+	virtual std::shared_ptr<std::vector<int> > GetModel() = 0;
 
-	inline virtual void AddConstraintOr(const std::vector<std::shared_ptr<std::vector<int> > > frame) = 0;
-	inline virtual void AddConstraintAnd(const std::vector<std::shared_ptr<std::vector<int> > > frame) = 0;
+	inline virtual void AddConstraintOr(const FrameView& frame) = 0;
+	inline virtual void AddConstraintAnd(const FrameView& frame) = 0;
 	inline virtual void FlipLastConstrain() = 0;
+	//every later query gives up after this many conflicts or propagations of its own, negative for no budget.
+	//the cadical backend only has the conflict budget
+	virtual void SetBudget(int64_t conflicts, int64_t propagations) = 0;
+	//the queries a single core minimization (-muc) may take, negative for no limit
+	virtual void SetMucBudget(int queries) = 0;
+	//makes the running query and every later one give up until ClearInterrupt(), safe to call from another thread
+	virtual void Interrupt() = 0;
+	virtual void ClearInterrupt() = 0;
+	inline SolveResult GetLastResult() const {return m_lastResult;}
+
+	//a query still running at the deadline gives up, as does every query after it.
+	//the deadline (in ticks of the steady clock) belongs to the check and may be moved from another thread
+	void SetDeadline(const std::atomic<std::chrono::steady_clock::rep>* deadline) {m_deadline = deadline;}
+
+	//a query still running when the flag is set gives up, as does every query after it.
+	//the flag belongs to the check and may be set from another thread
+	void SetStopFlag(const std::atomic<bool>* stop) {m_stop = stop;}
+
+	//from now on the clauses and solves of the solver are recorded in the trace
+	void SetTrace(std::shared_ptr<SatTrace> trace)
+	{
+		m_trace = trace;
+		if (m_trace != nullptr)
+		{
+			m_trace->BeginSolver();
+		}
+	}
+
 	virtual ~ISolver(){};
-private:
+protected:
+	inline bool ShouldGiveUp() const
+	{
+		return (m_stop != nullptr && m_stop->load(std::memory_order_relaxed)) || 
+			(m_deadline != nullptr && std::chrono::steady_clock::now().time_since_epoch().count() >= m_deadline->load(std::memory_order_relaxed));
+	}
+
+	//whether a query has to look out for ShouldGiveUp() while it runs
+	inline bool HasStopCondition() const {return m_deadline != nullptr || m_stop != nullptr;}
+
+	std::shared_ptr<SatTrace> m_trace;
+	SolveResult m_lastResult = SolveResult::Unknown;
+	const std::atomic<std::chrono::steady_clock::rep>* m_deadline = nullptr;
+	const std::atomic<bool>* m_stop = nullptr;
 };
 
 } //namespace car
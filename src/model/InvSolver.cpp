@@ -3,15 +3,72 @@
 
 namespace car
 {
-    InvSolver::InvSolver(std::shared_ptr<AigerModel> model)
+    InvSolver::InvSolver(std::shared_ptr<AigerModel> model, SatBackend backend, std::shared_ptr<SatTrace> trace)
     {
+        m_solver = NewSolver(backend, trace);
         m_model = model;
         m_maxFlag = model->GetMaxId()+1;
-        auto& clause = m_model->GetClause();
-        for (int i = 0, end = model->GetOutputsStart(); i < end ; i ++)
+        m_solver->AddClauses(m_model->GetClause(), 0, model->GetOutputsStart(), 0);
+    }
+
+    void InvSolver::UpdateFrame(const FrameView& frame, int frameLevel)
+    {
+        while (m_frameActs.size() <= frameLevel)
+        {
+            m_frameActs.push_back(0);
+        }
+        if (m_frameActs[frameLevel] != 0)
+        {
+            m_solver->AddClause(std::vector<int> {-m_frameActs[frameLevel]});
+        }
+        int act = GetNewVar();
+        std::vector<int> clause;
+        clause.reserve(frame.size() + 1);
+        clause.push_back(-act);
+        for (int i = 0; i < frame.size(); ++i)
+        {
+            clause.push_back(GetLemmaFlag(frame[i]));
+        }
+        m_solver->AddClause(clause);
+        m_frameActs[frameLevel] = act;
+    }
+
+    bool InvSolver::IsContained(const FrameView& frame, int frameLevel)
+    {
+        m_solver->ClearAssumption();
+        for (int i = 0; i < frameLevel; ++i)
+        {
+            m_solver->AddAssumption(m_frameActs[i]);
+        }
+        for (int i = 0; i < frame.size(); ++i)
+        {
+            m_solver->AddAssumption(-GetLemmaFlag(frame[i]));
+        }
+        m_solver->SolveWithAssumption();
+        return m_solver->GetLastResult() == SolveResult::Unsat;
+    }
+
+    int InvSolver::GetLemmaFlag(const Lemma& uc)
+    {
+        std::vector<int> key(uc.begin(), uc.end());
+        auto it = m_lemmaFlags.find(key);
+        if (it != m_lemmaFlags.end())
+        {
+            return it->second;
+        }
+        //flag <-> uc
+        int flag = GetNewVar();
+        std::vector<int> clause;
+        clause.reserve(uc.size() + 1);
+        clause.push_back(flag);
+        for (int i = 0; i < uc.size(); ++i)
         {
-            AddClause (clause[i]);
+            m_solver->AddClause(std::vector<int> {-flag, uc[i]});
+            clause.push_back(-uc[i]);
         }
+        m_solver->AddClause(clause);
+        m_lemmaFlags.emplace(key, flag);
+        return flag;
     }
 
-}//namespace car
\ No newline at end of file
+}//namespace car
@@ -1,27 +1,53 @@
 #ifndef INVSOLVER_H
 #define INVSOLVER_H
 
-#ifdef CADICAL
-#include "CarSolver_cadical.h"
-#else
-#include "CarSolver.h"
-#endif
+#include "MainSolver.h"
+#include <unordered_map>
 
 namespace car
 {
 
-#ifdef CADICAL
-class InvSolver : public CarSolver_cadical
-#else
-class InvSolver : public CarSolver
-#endif
-
+///
+//kept for the whole run. each uc gets a flag that is equivalent to the uc (as a cube) once and for all,
+//the negation of each frame is one clause over these flags, guarded by an activation literal of the frame,
+//and is replaced (old activation literal disabled) only when the frame changes
+///
+class InvSolver
 {
 public:
-    InvSolver(std::shared_ptr<AigerModel> model);
+    InvSolver(std::shared_ptr<AigerModel> model, SatBackend backend = SatBackend::Minisat, std::shared_ptr<SatTrace> trace = nullptr);
+
+    inline bool IsEncoded(int frameLevel) {return frameLevel < m_frameActs.size();}
+
+    //(re)encodes the negation of the frame, the frames below it are left as they are
+    void UpdateFrame(const FrameView& frame, int frameLevel);
+
+    //is the frame contained in the union of the (encoded) frames below it, a query that gave up says no
+    bool IsContained(const FrameView& frame, int frameLevel);
+
+    inline ISolver& GetSolver() {return *m_solver;}
+
 private:
+    struct LemmaHash
+    {
+        size_t operator()(const std::vector<int>& uc) const
+        {
+            return HashLemma(uc);
+        }
+    };
+
+    int GetLemmaFlag(const Lemma& uc);
+
+    inline int GetNewVar() {return m_maxFlag++;}
+
+    std::shared_ptr<ISolver> m_solver;
+    std::shared_ptr<AigerModel> m_model;
+    int m_maxFlag;
+
+    std::unordered_map<std::vector<int>, int, LemmaHash> m_lemmaFlags;
+    std::vector<int> m_frameActs;//m_frameActs[i] activates the negation of frame i
 };
 
 }//namespace car
 
-#endif
\ No newline at end of file
+#endif
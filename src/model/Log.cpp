@@ -1,4 +1,5 @@
 #include "Log.h"
+#include "MainSolver.h"
 
 namespace car
 {
@@ -12,9 +13,7 @@ namespace car
         m_log<<"Frame "<<sequence->GetLength()-1<<std::endl;
         for (int i = 0; i < sequence->GetLength(); ++i)
         {
-            std::vector<std::shared_ptr<std::vector<int> > > frame;
-            sequence->GetFrame(i, frame);
-            m_log<<frame.size()<<" ";
+            m_log<<sequence->GetFrameSize(i)<<" ";
         }
         m_log<<std::endl;
     }
@@ -23,52 +22,106 @@ namespace car
     {
         
         m_res <<"1"<<std::endl<<"b"<<badNo<<std::endl;
-        if (isForward)
+        if (lastState == nullptr)
         {
+            //no path was kept: bad in the initial state, under inputs found again from it
+            std::shared_ptr<std::vector<int> > inputs(new std::vector<int>());
+            std::shared_ptr<std::vector<int> > latches(new std::vector<int>(m_model->GetInitialState()));
+            std::vector<std::shared_ptr<State> > path {std::shared_ptr<State>(new State(nullptr, inputs, latches, 0))};
+            m_res<<path[0]->GetValueOfLatches()<<std::endl;
+            PrintInputs(path, path, badNo, true);
+        }
+        else if (isForward)
+        {
+            //the states from the initial one to bad, each with the inputs of its step
+            std::vector<std::shared_ptr<State> > path;
+            for (std::shared_ptr<State> state = lastState; state != nullptr; state = state->preState)
+            {
+                path.push_back(state);
+            }
+            m_res<<lastState->GetValueOfLatches()<<std::endl;
+            PrintInputs(path, path, badNo);
+        }
+        else
+        {
+            //a state keeps the inputs of the step into it, the last one those that make bad true in its predecessor
+            std::stack<std::shared_ptr<State> > trace;
             std::shared_ptr<State> state = lastState;
-            m_res<<state->GetValueOfLatches()<<std::endl;
-            m_res<<state->GetValueOfInputs()<<std::endl;
-            while(state->preState != nullptr)
+            while (state != nullptr)
             {
+                trace.push(state);
                 state = state->preState;
+            }
+            std::vector<std::shared_ptr<State> > path;
+            while (!trace.empty())
+            {
+                path.push_back(trace.top());
+                trace.pop();
+            }
+            m_res << path[0]->GetValueOfLatches()<<std::endl;
+            std::vector<std::shared_ptr<State> > steps(path.begin() + 1, path.end());
+            path.pop_back();
+            PrintInputs(path, steps, badNo);
+        }
+        m_res<<"."<<std::endl;
+    }
+
+    void Log::PrintInputs(const std::vector<std::shared_ptr<State> >& path, const std::vector<std::shared_ptr<State> >& steps, int badNo, bool findInputs)
+    {
+        if (!m_settings.lazyInputs && !findInputs)
+        {
+            for (auto& state : steps)
+            {
                 m_res<<state->GetValueOfInputs()<<std::endl;
             }
+            return;
         }
-        else
+        //one query per step from the concrete state reached so far: T, the next state of the path, 
+        //and bad in the last state
+        std::shared_ptr<ISolver> solver = NewSolver(m_settings.mainSat);
+        const Cnf& clauses = m_model->GetClause();
+        solver->AddClauses(clauses, 0, clauses.size(), 0);
+        std::vector<int> current = *path[0]->GetLatches();
+        for (int i = 0; i < path.size(); ++i)
         {
-            if (lastState == nullptr)
+            solver->ClearAssumption();
+            for (int lit : current)
             {
-                for (int i = 0; i < m_model->GetNumLatches(); ++i)
-                {
-                    m_res<<"0";
-                }
-                m_res<<std::endl;
-                for (int i = 0; i < m_model->GetNumInputs(); ++i)
+                solver->AddAssumption(lit);
+            }
+            if (i + 1 < path.size())
+            {
+                std::shared_ptr<std::vector<int> > next = path[i+1]->GetLatches();
+                for (int lit : *next)
                 {
-                    m_res<<"0";
+                    solver->AddAssumption(m_model->GetPrime(lit));
                 }
-                m_res<<std::endl;
             }
             else
             {
-                std::stack<std::shared_ptr<State> > trace;
-                std::shared_ptr<State> state = lastState;
-                while (state != nullptr)
-                {
-                    trace.push(state);
-                    state = state->preState;
-                }
-                m_res << trace.top()->GetValueOfLatches()<<std::endl;
-                //m_res << trace.top()->GetValueOfInputs()<<std::endl;
-                trace.pop();
-                while(!trace.empty())
-                {
-                    m_res<<trace.top()->GetValueOfInputs()<<std::endl;
-                    trace.pop();
-                }
+                solver->AddAssumption(m_model->GetOutputs()[badNo]);
+            }
+            //the path came from the checker, so this only fails on a bug. the inputs found so far are kept,
+            //a witness cut short is rejected rather than one with made-up inputs accepted
+            if (!solver->SolveWithAssumption())
+            {
+                m_log<<"no inputs found for step "<<i<<" of the counterexample, the witness is incomplete"<<std::endl;
+                std::cout<<"no inputs found for step "<<i<<" of the counterexample, the witness is incomplete"<<std::endl;
+                return;
+            }
+            std::shared_ptr<std::vector<int> > model = solver->GetModel();
+            for (int j = 0; j < m_model->GetNumInputs(); ++j)
+            {
+                m_res<<(j < model->size() && model->at(j) > 0 ? "1" : "0");
+            }
+            m_res<<std::endl;
+            current.clear();
+            for (int j = m_model->GetNumInputs(), end = m_model->GetNumInputs() + m_model->GetNumLatches(); j < end; ++j)
+            {
+                int prime = m_model->GetPrime(j+1);
+                current.push_back(prime <= model->size() && model->at(prime-1) > 0 ? j+1 : -j-1);
             }
         }
-        m_res<<"."<<std::endl;
     }
 
     void Log::PrintSafe(int badNo)
@@ -76,6 +129,11 @@ namespace car
         m_res <<"0"<<std::endl<<"b"<<badNo<<std::endl<<"."<<std::endl;
     }
 
+    void Log::PrintUnknown(int badNo)
+    {
+        m_res <<"2"<<std::endl<<"b"<<badNo<<std::endl<<"."<<std::endl;
+    }
+
     void Log::PrintUcNums(std::vector<int> &uc, IOverSequence* sequence)
     {
         m_debug<<"SAT调用结果，UNSAT"<<std::endl<<"新uc=";
@@ -86,9 +144,7 @@ namespace car
         m_debug<<std::endl<<"Frame:\t";
         for (int i = 0; i < sequence->GetLength(); ++i)
         {
-            std::vector<std::shared_ptr<std::vector<int> > > frame;
-            sequence->GetFrame(i, frame);
-            m_debug<<frame.size()<<" ";
+            m_debug<<sequence->GetFrameSize(i)<<" ";
         }
         m_debug<<std::endl;
     }
@@ -5,31 +5,41 @@
 #include <fstream>
 #include "State.h"
 #include <time.h>
+#include <chrono>
 #include <stack>
 #include "OverSequence.h"
 #include "AigerModel.h"
 #include <memory>
 #include "Settings.h"
+#include "SatTrace.h"
+#include <map>
+#include <atomic>
+#include <mutex>
 #include <assert.h>
 namespace car
 {
 
+//thrown by Log::Timeout() in a check on a thread of its own, which must end without ending the run
+struct CheckStopped {};
+
 class Log
 {
 public:
-    Log(Settings settings, std::shared_ptr<AigerModel> model) : m_settings(settings)
+    Log(Settings settings, std::shared_ptr<AigerModel> model) : m_settings(settings), m_stopped(false)
     {
-        string outPath = settings.outputDir + GetFileName(settings.aigFilePath);
+        m_outPath = GetOutPath(settings);
         m_model = model;
-        m_res.open(outPath + ".res");
-        m_log.open(outPath + ".log");
+        m_res.open(m_outPath + ".res");
+        m_log.open(m_outPath + ".log");
         if (settings.debug)
         {
-            m_debug.open(outPath + ".debug");
+            m_debug.open(m_outPath + ".debug");
         } 
-        m_timelimit = static_cast<double>(settings.timelimit/model->GetNumOutputs());
+        m_timelimit = settings.property >= 0 ? settings.timelimit : static_cast<double>(settings.timelimit/model->GetNumOutputs());
         lastState = nullptr;
         m_begin = clock();
+        m_wallBegin = std::chrono::steady_clock::now();
+        SetDeadline();
         m_restartTimes = 0;
     }
 
@@ -43,6 +53,22 @@ public:
         } 
     }
     
+    //the trace of a solver role, null unless tracing is on.
+    //the solvers of one role share a trace file, each one starts a new solver in it
+    std::shared_ptr<SatTrace> GetTrace(const std::string& role)
+    {
+        if (!m_settings.trace)
+        {
+            return nullptr;
+        }
+        std::shared_ptr<SatTrace>& trace = m_traces[role];
+        if (trace == nullptr)
+        {
+            trace.reset(new SatTrace(m_outPath + "." + role + ".trace"));
+        }
+        return trace;
+    }
+
     void PrintSth(std::string s);
 
     void PrintFramesInfo(IOverSequence* sequence);
@@ -51,6 +77,9 @@ public:
 
     void PrintSafe(int badNo);
 
+    //the result of a property that was given up on, e.g. out of time
+    void PrintUnknown(int badNo);
+
     void PrintUcNums(std::vector<int> &uc, IOverSequence* sequence);
 
     void PrintSAT(std::vector<int>& vec, int frameLevel);
@@ -69,6 +98,8 @@ public:
     void ResetClock()
     {
         m_begin = clock();
+        m_wallBegin = std::chrono::steady_clock::now();
+        SetDeadline();
         m_mainSolverTime = 0;
         m_mainSolverCalls = 0;
         m_invSolverCalls = 0;
@@ -78,17 +109,56 @@ public:
         m_updateUcTime = 0;
     }
 
+    //a check on a thread of its own (a portfolio worker or a scheduled property) unwinds to it, 
+    //any other check ends the run
     void Timeout()
     {
         PrintStatistics();
+        if (m_settings.worker >= 0 || m_settings.property >= 0)
+        {
+            throw CheckStopped();
+        }
         exit(0);
     }
 
+    //wall-clock time, since the cpu time of the process counts every thread of a portfolio
     bool IsTimeout()
     {
-        clock_t current = clock();
-        double seconds = static_cast<double>(current - m_begin) / (CLOCKS_PER_SEC );
-        return seconds > m_timelimit;
+        return m_stopped || std::chrono::steady_clock::now().time_since_epoch().count() > m_deadline.load(std::memory_order_relaxed);
+    }
+
+    //makes the check give up, safe to call from another thread. 
+    //the solvers see it through GetStopFlag(), the check itself at its next query
+    void Stop() {m_stopped = true;}
+
+    const std::atomic<bool>* GetStopFlag() const {return &m_stopped;}
+
+    //the path of the output files without extension, tagged with the worker in a portfolio
+    //and with the property when it is checked alone
+    static string GetOutPath(const Settings& settings)
+    {
+        string outPath = settings.outputDir + GetFileName(settings.aigFilePath);
+        if (settings.worker >= 0)
+        {
+            outPath += ".w" + std::to_string(settings.worker);
+        }
+        if (settings.property >= 0)
+        {
+            outPath += ".p" + std::to_string(settings.property);
+        }
+        return outPath;
+    }
+
+    //the time limit of the current check as a wall-clock deadline, so that a solver can give up in the middle of a query.
+    //it moves with ExtendTimelimit(), so a solver keeps the deadline itself rather than a copy
+    const std::atomic<std::chrono::steady_clock::rep>* GetDeadline() const {return &m_deadline;}
+
+    //gives the check this many more seconds, safe to call from another thread
+    void ExtendTimelimit(double seconds)
+    {
+        std::lock_guard<std::mutex> lock(m_deadlineMutex);
+        m_timelimit += seconds;
+        m_deadline += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds)).count();
     }
 
     void Tick()
@@ -123,8 +193,18 @@ public:
     std::ofstream m_res;
     std::ofstream m_debug;
 private:
+    //the input lines of a counterexample, one per step of path (from the initial state to the one bad is true in).
+    //the inputs kept by steps, or with lazyInputs or findInputs, inputs found again along path
+    void PrintInputs(const std::vector<std::shared_ptr<State> >& path, const std::vector<std::shared_ptr<State> >& steps, int badNo, bool findInputs = false);
+
+    //from m_wallBegin and the time limit
+    void SetDeadline()
+    {
+        std::lock_guard<std::mutex> lock(m_deadlineMutex);
+        m_deadline = (m_wallBegin + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(m_timelimit))).time_since_epoch().count();
+    }
 
-    string GetFileName(string filePath)
+    static string GetFileName(string filePath)
 	{
 		auto startIndex = filePath.find_last_of("/");
 		if (startIndex == string::npos)
@@ -151,9 +231,15 @@ private:
     std::shared_ptr<AigerModel> m_model;
     clock_t m_tick;
     clock_t m_begin;
+    std::chrono::steady_clock::time_point m_wallBegin;
     
     std::ofstream m_log;
+    std::map<std::string, std::shared_ptr<SatTrace> > m_traces;//by solver role
     Settings m_settings;
+    string m_outPath;
+    std::atomic<bool> m_stopped;
+    std::atomic<std::chrono::steady_clock::rep> m_deadline;//in ticks of the steady clock
+    std::mutex m_deadlineMutex;//between ExtendTimelimit() and the check restarting its clock
     
 };
 
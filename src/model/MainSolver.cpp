@@ -2,17 +2,28 @@
 
 namespace car
 {
-    MainSolver::MainSolver(std::shared_ptr<AigerModel> model, bool isForward, bool extractMUC)
+    std::shared_ptr<ISolver> NewMainSolver(SatBackend backend, std::shared_ptr<AigerModel> model, bool isForward, bool extractMUC, int unroll, std::shared_ptr<SatTrace> trace)
     {
-        m_isForward = isForward;
-        m_extractMUC = extractMUC;
-        m_model = model;
-        m_maxFlag = model->GetMaxId()+1;
-		auto& clause = m_model->GetClause();
-		for (int i = 0; i < clause.size(); ++i)
-		{
-			AddClause(clause[i]);
-		}
+        if (backend == SatBackend::Cadical)
+        {
+            return std::shared_ptr<ISolver>(new MainSolver<CarSolver_cadical>(model, isForward, extractMUC, unroll, trace));
+        }
+        return std::shared_ptr<ISolver>(new MainSolver<CarSolver>(model, isForward, extractMUC, unroll, trace));
     }
 
-}//namespace car
\ No newline at end of file
+    std::shared_ptr<ISolver> NewSolver(SatBackend backend, std::shared_ptr<SatTrace> trace)
+    {
+        std::shared_ptr<ISolver> solver;
+        if (backend == SatBackend::Cadical)
+        {
+            solver.reset(new CarSolver_cadical());
+        }
+        else
+        {
+            solver.reset(new CarSolver());
+        }
+        solver->SetTrace(trace);
+        return solver;
+    }
+
+}//namespace car
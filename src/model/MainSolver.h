@@ -1,31 +1,67 @@
 #ifndef MAINSOLVER_H
 #define MAINSOLVER_H
 
-#ifdef CADICAL
-#include "CarSolver_cadical.h"
-#else
 #include "CarSolver.h"
-#endif
+#include "CarSolver_cadical.h"
+#include "Settings.h"
 
 namespace car
 {
 
-#ifdef CADICAL
-class MainSolver : public CarSolver_cadical
-{
-public:
-    MainSolver(std::shared_ptr<AigerModel> model, bool isForward);
-#else
-class MainSolver : public CarSolver
+///
+//the solver of the one-step (or unrolled) queries, on top of either SAT backend
+///
+template <class SatSolver>
+class MainSolver : public SatSolver
 {
 public:
-    MainSolver(std::shared_ptr<AigerModel> model, bool isForward, bool extractMUC = false);
-#endif
+    MainSolver(std::shared_ptr<AigerModel> model, bool isForward, bool extractMUC = false, int unroll = 1, std::shared_ptr<SatTrace> trace = nullptr)
+    {
+        this->SetTrace(trace);
+        this->m_isForward = isForward;
+        this->m_extractMUC = extractMUC;
+        this->m_unroll = unroll;
+        this->m_model = model;
+        //levels 0..unroll are taken by the unrolled variables, flags start above them
+        this->m_maxFlag = model->GetMaxId()*(unroll+1)+1;
+		//copy i of T ranges over levels i and i+1, 
+		//gates are shared between the sections of the clauses, so every section is copied.
+		//the copies other than the one of the one-step query only hold under a flag of their own,
+		//which only the unrolled query assumes: else they would ask for k steps around every state
+		const Cnf& clause = model->GetTransitionClause();
+		std::vector<int> guarded;
+		for (int level = 0; level < unroll; ++level)
+		{
+			int shift = model->GetMaxId()*level;
+			if (level == this->GetStepLevel())
+			{
+				this->AddClauses(clause, 0, clause.size(), shift);
+				continue;
+			}
+			int flag = this->GetNewVar();
+			this->m_unrollFlags.push_back(flag);
+			for (int i = 0; i < clause.size(); ++i)
+			{
+				guarded.assign(1, -flag);
+				for (int lit : clause[i])
+				{
+					guarded.push_back(lit > 0 ? lit + shift : lit - shift);
+				}
+				this->AddClause(guarded);
+			}
+		}
+    }
 
 private:
 
 };
 
+//the solvers record their clauses and solves in the trace, if there is one
+std::shared_ptr<ISolver> NewMainSolver(SatBackend backend, std::shared_ptr<AigerModel> model, bool isForward, bool extractMUC = false, int unroll = 1, std::shared_ptr<SatTrace> trace = nullptr);
+
+//an empty solver of the backend, for the solvers that only need ISolver's clause and assumption interface
+std::shared_ptr<ISolver> NewSolver(SatBackend backend, std::shared_ptr<SatTrace> trace = nullptr);
+
 }
 
-#endif
\ No newline at end of file
+#endif
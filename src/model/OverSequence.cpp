@@ -2,30 +2,17 @@
 
 namespace car
 {
-	void OverSequence::Insert(std::shared_ptr<std::vector<int> > uc, int index) 
+	void OverSequence::Insert(const std::vector<int>& uc, int index) 
 	{
-		
-
 		if (index >= m_sequence.size())
 		{
-			m_sequence.push_back(std::vector<std::shared_ptr<std::vector<int> > >());
-		}
-		if (isForward && index == 0)
-		{
-			m_sequence[0].push_back(uc);
-			return;
+			m_sequence.emplace_back(m_numInputs);
 		}
-		std::vector<std::shared_ptr<std::vector<int> > > tmp;
-		tmp.reserve(m_sequence[index].size()+1);
-		for (int i = 0; i < m_sequence[index].size(); ++i)
+		if (!(isForward && index == 0))
 		{
-			if (!IsImply(*m_sequence[index][i], *uc))
-			{
-				tmp.push_back(m_sequence[index][i]);
-			}
+			m_sequence[index].RemoveImplied(uc);
 		}
-		m_sequence[index].swap(tmp);
-		m_sequence[index].push_back(uc);
+		m_sequence[index].Push(uc);
 	}
 
 	/*
@@ -52,47 +39,22 @@ namespace car
 	}
 	*/
 
-	void OverSequence::GetFrame(int frameLevel, std::vector<std::shared_ptr<std::vector<int> > >& out) 
+	FrameView OverSequence::GetFrame(int frameLevel) 
+	{
+		if (frameLevel >= m_sequence.size()) return FrameView();
+		return FrameView(m_sequence[frameLevel].GetUcs());
+	}
+
+	int OverSequence::GetFrameSize(int frameLevel)
 	{
-		if (frameLevel >= m_sequence.size()) return;
-		out = m_sequence[frameLevel];
+		if (frameLevel >= m_sequence.size()) return 0;
+		return m_sequence[frameLevel].Size();
 	}
 	
-	bool OverSequence::IsBlockedByFrame(std::vector<int>& state, int frameLevel, bool isPartial)
+	bool OverSequence::IsBlockedByFrame(const PackedState& state, int frameLevel)
 	{
-		if(!isPartial)
-		{
-			int index;
-			for (int i = 0; i < m_sequence[frameLevel].size(); ++i)//for each uc
-			{
-				bool isBlockedByUc = true;
-				for (int j = 0; j < m_sequence[frameLevel][i]->size(); ++j)//for each literal in uc
-				{
-					index = abs((*m_sequence[frameLevel][i])[j]) - m_numInputs - 1;
-					if (state[index] != (*m_sequence[frameLevel][i])[j])
-					{
-						isBlockedByUc = false;
-						break;
-					}
-				}
-				if (isBlockedByUc)
-				{
-					return true;
-				}
-			}	
-		}
-		else
-		{
-			for (int i = 0; i < m_sequence[frameLevel].size(); ++i)//for each uc
-			{	 
-				if (IsImply(state,*(m_sequence[frameLevel][i])))
-				{
-					return true;
-				}
-			}	
-		}
-		
-		return false;
+		//covers partial states as well: a uc blocks a state iff the uc is a subset of it
+		return m_sequence[frameLevel].IsBlocking(state);
 	}
 	
 	int OverSequence::GetLength()
@@ -100,19 +62,33 @@ namespace car
 		return m_sequence.size();
 	}
 
-    bool OverSequence::IsImply (std::vector<int>& v1,  std::vector<int>& v2) //if v2->v1
+	bool OverSequence::IsSyntacticFixpoint(int frameLevel)
 	{
-
-		if (v1.size () < v2.size ())
+		if (frameLevel < 1 || frameLevel >= m_sequence.size())
+		{
 			return false;
-		std::vector<int>::iterator first1 = v1.begin (), first2 = v2.begin (), last1 = v1.end (), last2 = v2.end ();
-		while (first2 != last2) 
+		}
+		const Frame& frame = m_sequence[frameLevel];
+		const UcArena& previous = m_sequence[frameLevel - 1].GetUcs();
+		if (frame.Size() == previous.size() && frame.GetFingerprint() == m_sequence[frameLevel - 1].GetFingerprint())
 		{
-			if ( (first1 == last1) || comp (*first2, *first1) ) 
+			//most likely the same frame, which exact lookups confirm without any subset scan
+			bool same = true;
+			for (int i = 0; i < previous.size() && same; ++i)
+			{
+				same = frame.Contains(previous[i]);
+			}
+			if (same)
+			{
+				return true;
+			}
+		}
+		for (int i = 0; i < previous.size(); ++i)
+		{
+			if (!frame.HasSubsetOf(previous[i]))
+			{
 				return false;
-			if ((*first1) == (*first2)) 
-				++ first2;
-			++ first1;
+			}
 		}
 		return true;
 	}
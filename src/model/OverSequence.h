@@ -4,6 +4,7 @@
 #include <vector>
 #include <cmath>
 #include "IOverSequence.h"
+#include "Frame.h"
 #include<memory>
 namespace car
 {
@@ -17,23 +18,25 @@ public:
 
 	}
 
-	void Insert(std::shared_ptr<std::vector<int> > uc, int index) override;
+	void Insert(const std::vector<int>& uc, int index) override;
 	
-	void GetFrame(int frameLevel, std::vector<std::shared_ptr<std::vector<int> > >& out) override;
+	FrameView GetFrame(int frameLevel) override;
+
+	int GetFrameSize(int frameLevel) override;
 	
-	bool IsBlockedByFrame(std::vector<int>& state, int frameLevel, bool isPartial) override;
+	bool IsBlockedByFrame(const PackedState& state, int frameLevel) override;
 	
 	int GetLength() override;
 
-private:
-	bool IsImply ( std::vector<int>& v1,  std::vector<int>& v2);
+	bool IsSyntacticFixpoint(int frameLevel) override;
 
+private:
 	bool comp (int i, int j)
 	{
 		return abs (i) < abs(j);
 	}
 
-	bool comp (std::vector<int>& a, std::vector<int>& b)
+	bool comp (const Lemma& a, const Lemma& b)
 	{
 		if (a.size() < b.size())
 		{
@@ -60,7 +63,8 @@ private:
 	
 	int GetInsertPos(std::vector<int>& uc, int frameLevel)
 	{
-		int left = 0, right = m_sequence[frameLevel].size()-1;
+		const UcArena& frame = m_sequence[frameLevel].GetUcs();
+		int left = 0, right = frame.size()-1;
 		if (right == -1)
 		{
 			return 0;
@@ -69,7 +73,7 @@ private:
 		while (left < right)
 		{
 			mid = (left + right)/2;
-			if (comp(*m_sequence[frameLevel][mid], uc))
+			if (comp(frame[mid], uc))
 			{
 				left = mid + 1;
 			}
@@ -78,7 +82,7 @@ private:
 				right = mid - 1;
 			}
 		}
-		if (comp(*m_sequence[frameLevel][left], uc))
+		if (comp(frame[left], uc))
 		{
 			return left+1;
 		}
@@ -89,7 +93,7 @@ private:
 	}
 
 	int m_numInputs;
-	std::vector<std::vector<std::shared_ptr<std::vector<int> > > > m_sequence;//frameLevel //uc //literal m_sequence[0][2]
+	std::vector<Frame> m_sequence;//frameLevel //uc //literal m_sequence[0].GetUcs()[2]
 	//for()
 
 };
@@ -2,86 +2,33 @@
 
 namespace car
 {
-    void OverSequenceForProp::Insert(std::shared_ptr<std::vector<int> > uc, int index) 
+    void OverSequenceForProp::Insert(const std::vector<int>& uc, int index) 
 	{
 		if (index >= m_unprop.size())
 		{
-			m_unprop.emplace_back(std::vector<std::shared_ptr<std::vector<int> > >());
-            m_prop.emplace_back(std::vector<std::shared_ptr<std::vector<int> > >());
+			m_unprop.emplace_back(m_numInputs);
+            m_prop.emplace_back(m_numInputs);
 		}
-		std::vector<std::shared_ptr<std::vector<int> > > tmp;
-		tmp.reserve(m_unprop[index].size()+1);
-		for (int i = 0; i < m_unprop[index].size(); ++i)
-		{
-			if (!IsImply(*m_unprop[index][i], *uc))
-			{
-				tmp.push_back(m_unprop[index][i]);
-			}
-		}
-		m_unprop[index].swap(tmp);
-        
-        tmp.clear();
-        for (int i = 0; i < m_prop[index].size(); ++i)
-		{
-			if (!IsImply(*m_prop[index][i], *uc))
-			{
-				tmp.push_back(m_prop[index][i]);
-			}
-		}
-		m_prop[index].swap(tmp);
-		m_unprop[index].push_back(uc);
+		m_unprop[index].RemoveImplied(uc);
+		m_prop[index].RemoveImplied(uc);
+		m_unprop[index].Push(uc);
 	}
 
-	void OverSequenceForProp::GetFrame(int frameLevel, std::vector<std::shared_ptr<std::vector<int> > >& out) 
+	FrameView OverSequenceForProp::GetFrame(int frameLevel) 
 	{
-		if (frameLevel >= m_prop.size()) return;
-        std::vector<std::shared_ptr<std::vector<int> > > tmp;
-        tmp.reserve(m_prop[frameLevel].size() + m_unprop[frameLevel].size());
-        tmp.insert(tmp.begin(), m_unprop[frameLevel].begin(), m_unprop[frameLevel].end());
-        tmp.insert(tmp.end(), m_prop[frameLevel].begin(), m_prop[frameLevel].end());
-		out.swap(tmp);
+		if (frameLevel >= m_prop.size()) return FrameView();
+		return FrameView(m_unprop[frameLevel].GetUcs(), m_prop[frameLevel].GetUcs());
 	}
 
-	bool OverSequenceForProp::IsBlockedByFrame(std::vector<int>& state, int frameLevel)
+	int OverSequenceForProp::GetFrameSize(int frameLevel)
 	{
-		int index;
-		for (int i = 0; i < m_prop[frameLevel].size(); ++i)//for each uc
-		{
-			bool isBlockedByUc = true;
-			for (int j = 0; j < m_prop[frameLevel][i]->size(); ++j)//for each literal in uc
-			{
-				index = abs((*m_prop[frameLevel][i])[j]) - m_numInputs - 1;
-				if (state[index] != (*m_prop[frameLevel][i])[j])
-				{
-					isBlockedByUc = false;
-					break;
-				}
-			}
-			if (isBlockedByUc)
-			{
-				return true;
-			}
-		}
-
-        for (int i = 0; i < m_unprop[frameLevel].size(); ++i)//for each uc
-		{
-			bool isBlockedByUc = true;
-			for (int j = 0; j < m_unprop[frameLevel][i]->size(); ++j)//for each literal in uc
-			{
-				index = abs((*m_unprop[frameLevel][i])[j]) - m_numInputs - 1;
-				if (state[index] != (*m_unprop[frameLevel][i])[j])
-				{
-					isBlockedByUc = false;
-					break;
-				}
-			}
-			if (isBlockedByUc)
-			{
-				return true;
-			}
-		}
+		if (frameLevel >= m_prop.size()) return 0;
+		return m_unprop[frameLevel].Size() + m_prop[frameLevel].Size();
+	}
 
-		return false;
+	bool OverSequenceForProp::IsBlockedByFrame(const PackedState& state, int frameLevel)
+	{
+		return m_prop[frameLevel].IsBlocking(state) || m_unprop[frameLevel].IsBlocking(state);
 	}
 	
 	int OverSequenceForProp::GetLength()
@@ -89,19 +36,25 @@ namespace car
 		return m_unprop.size();
 	}
 
-    bool OverSequenceForProp::IsImply ( std::vector<int>& v1,  std::vector<int>& v2)
+	bool OverSequenceForProp::IsSyntacticFixpoint(int frameLevel)
 	{
-
-		if (v1.size () < v2.size ())
+		if (frameLevel < 1 || frameLevel >= m_prop.size())
+		{
 			return false;
-		std::vector<int>::iterator first1 = v1.begin (), first2 = v2.begin (), last1 = v1.end (), last2 = v2.end ();
-		while (first2 != last2) 
+		}
+		//the propagated and unpropagated ucs of a level together make up its frame
+		const Frame* frame[2] = {&m_unprop[frameLevel], &m_prop[frameLevel]};
+		const UcArena* previous[2] = {&m_unprop[frameLevel - 1].GetUcs(), &m_prop[frameLevel - 1].GetUcs()};
+		for (int p = 0; p < 2; ++p)
 		{
-			if ( (first1 == last1) || comp (*first2, *first1) ) 
-				return false;
-			if ((*first1) == (*first2)) 
-				++ first2;
-			++ first1;
+			for (int i = 0; i < previous[p]->size(); ++i)
+			{
+				Lemma uc = (*previous[p])[i];
+				if (!frame[0]->HasSubsetOf(uc) && !frame[1]->HasSubsetOf(uc))
+				{
+					return false;
+				}
+			}
 		}
 		return true;
 	}
@@ -2,6 +2,7 @@
 #define OVERSEQUENCEFORPROP_H
 
 #include "IOverSequence.h"
+#include "Frame.h"
 #include <cmath>
 #include <memory>
 namespace car
@@ -17,54 +18,43 @@ public:
 
 	}
 
-	void Insert(std::shared_ptr<std::vector<int> > uc, int index) override;
+	void Insert(const std::vector<int>& uc, int index) override;
 	
-	void GetFrame(int frameLevel, std::vector<std::shared_ptr<std::vector<int> > >& out) override;
+	FrameView GetFrame(int frameLevel) override;
+
+	int GetFrameSize(int frameLevel) override;
 	
-	bool IsBlockedByFrame(std::vector<int>& state, int frameLevel) override;
+	bool IsBlockedByFrame(const PackedState& state, int frameLevel) override;
 	
 	int GetLength() override;
 
-	std::vector<std::shared_ptr<std::vector<int> > >& GetProp(int frameLevel)
+	bool IsSyntacticFixpoint(int frameLevel) override;
+
+	FrameView GetProp(int frameLevel)
 	{
-		return m_prop[frameLevel];
+		return FrameView(m_prop[frameLevel].GetUcs());
 	}
 
-	std::vector<std::shared_ptr<std::vector<int> > >& GetUnProp(int frameLevel)
+	FrameView GetUnProp(int frameLevel)
 	{
-		return m_unprop[frameLevel];
+		return FrameView(m_unprop[frameLevel].GetUcs());
 	}
 
-	void InsertIntoProped(std::shared_ptr<std::vector<int> > uc, int index)
+	void InsertIntoProped(const std::vector<int>& uc, int index)
 	{
 		if (index >= m_prop.size())
 		{
-			m_unprop.emplace_back(std::vector<std::shared_ptr<std::vector<int> > >());
-            m_prop.emplace_back(std::vector<std::shared_ptr<std::vector<int> > >());
-		}
-		std::vector<std::shared_ptr<std::vector<int> > > tmp;
-        for (int i = 0; i < m_prop[index].size(); ++i)
-		{
-			if (!IsImply(*m_prop[index][i], *uc))
-			{
-				tmp.push_back(m_prop[index][i]);
-			}
+			m_unprop.emplace_back(m_numInputs);
+            m_prop.emplace_back(m_numInputs);
 		}
-		m_prop[index].swap(tmp);
-		m_prop[index].push_back(uc);
+		m_prop[index].RemoveImplied(uc);
+		m_prop[index].Push(uc);
 	}
 
 private:
-	bool IsImply ( std::vector<int>& v1,  std::vector<int>& v2);
-
-	bool comp (int i, int j)
-	{
-		return abs (i) < abs(j);
-	}
-	
 	int m_numInputs;
-	std::vector<std::vector<std::shared_ptr<std::vector<int> > > > m_unprop;
-	std::vector<std::vector<std::shared_ptr<std::vector<int> > > > m_prop;
+	std::vector<Frame> m_unprop;
+	std::vector<Frame> m_prop;
 	//for()
 };
 
@@ -0,0 +1,193 @@
+#ifndef PACKEDCUBE_H
+#define PACKEDCUBE_H
+
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <algorithm>
+#include "UcArena.h"
+
+namespace car
+{
+
+///
+//a cube over latches packed into 64-bit lanes, each lane holds two words: the values and the care mask.
+//bit i stands for the latch numInputs+1+i, a latch not in the cube (partial state) has its care bit cleared
+///
+class PackedState
+{
+public:
+	PackedState() {}
+	PackedState(const Lemma& cube, int numInputs, int numLatches)
+	{
+		m_words.resize(2*((numLatches + 63) / 64), 0);
+		for (int i = 0; i < cube.size(); ++i)
+		{
+			int index = abs(cube[i]) - numInputs - 1;
+			uint64_t bit = 1ull << (index & 63);
+			m_words[2*(index >> 6) + 1] |= bit;
+			if (cube[i] > 0)
+			{
+				m_words[2*(index >> 6)] |= bit;
+			}
+		}
+	}
+
+	inline uint64_t Value(int lane) const {return m_words[2*lane];}
+
+	inline uint64_t Care(int lane) const {return m_words[2*lane + 1];}
+
+	inline int GetLanes() const {return m_words.size() / 2;}
+
+	inline bool HasLiteral(int lit, int numInputs) const
+	{
+		int index = abs(lit) - numInputs - 1;
+		uint64_t bit = 1ull << (index & 63);
+		return (Care(index >> 6) & bit) && (((Value(index >> 6) & bit) != 0) == (lit > 0));
+	}
+
+	//the literals in the order of latches
+	std::shared_ptr<std::vector<int> > ToVector(int numInputs, int numLatches) const
+	{
+		std::shared_ptr<std::vector<int> > res(new std::vector<int>());
+		res->reserve(numLatches);
+		AppendTo(*res, numInputs, numLatches);
+		return res;
+	}
+
+	//the literals in the order of latches, added at the end of out without any allocation of its own
+	void AppendTo(std::vector<int>& out, int numInputs, int numLatches) const
+	{
+		for (int i = 0; i < numLatches; ++i)
+		{
+			uint64_t bit = 1ull << (i & 63);
+			if (Care(i >> 6) & bit)
+			{
+				out.push_back((Value(i >> 6) & bit) ? (numInputs + 1 + i) : -(numInputs + 1 + i));
+			}
+		}
+	}
+
+	bool operator== (const PackedState& other) const
+	{
+		return m_words == other.m_words;
+	}
+
+	//mixes every value and care word, equal states hash equal
+	uint64_t Hash() const
+	{
+		uint64_t h = m_words.size();
+		for (uint64_t word : m_words)
+		{
+			h ^= word + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+			h *= 0xff51afd7ed558ccdull;
+		}
+		return h ^ (h >> 33);
+	}
+
+private:
+	std::vector<uint64_t> m_words;
+};
+
+struct PackedLane
+{
+	uint64_t value;
+	uint64_t care;
+	int index;
+};
+
+///
+//a uc keeps only the lanes it has literals in, since ucs are far shorter than states.
+//the lanes are owned by the caller, so the lanes of all ucs of a frame can be stored one after another
+///
+class PackedUc
+{
+public:
+	PackedUc(const PackedLane* lanes, int numLanes): m_lanes(lanes), m_numLanes(numLanes) {}
+
+	//appends the lanes of uc to out, returns how many were appended
+	static int Pack(const Lemma& uc, int numInputs, std::vector<PackedLane>& out)
+	{
+		int start = out.size();
+		for (int i = 0; i < uc.size(); ++i)
+		{
+			int index = abs(uc[i]) - numInputs - 1;
+			int lane = index >> 6;
+			int pos = out.size() - 1;
+			//ucs are sorted by latch, so the lane is almost always the last one
+			while (pos >= start && out[pos].index != lane) --pos;
+			if (pos < start)
+			{
+				out.push_back(PackedLane{0, 0, lane});
+				pos = out.size() - 1;
+			}
+			uint64_t bit = 1ull << (index & 63);
+			out[pos].care |= bit;
+			if (uc[i] > 0)
+			{
+				out[pos].value |= bit;
+			}
+		}
+		return out.size() - start;
+	}
+
+	//state is blocked iff it agrees with every literal of the uc
+	inline bool IsBlocking(const PackedState& state) const
+	{
+		return Conflict(state) < 0;
+	}
+
+	//the last lane the uc has literals in, -1 for the empty uc
+	inline int GetLastLane() const
+	{
+		int res = -1;
+		for (int i = 0; i < m_numLanes; ++i)
+		{
+			res = std::max(res, m_lanes[i].index);
+		}
+		return res;
+	}
+
+	//a literal is coded as 2*latchIndex for the positive one and 2*latchIndex+1 for the negative one
+	//the code of a literal of the uc that the state does not agree with, -1 if the state is blocked
+	inline int Conflict(const PackedState& state) const
+	{
+		for (int i = 0; i < m_numLanes; ++i)
+		{
+			const PackedLane& lane = m_lanes[i];
+			uint64_t diff = (lane.care & ~state.Care(lane.index)) | ((lane.value ^ state.Value(lane.index)) & lane.care);
+			if (diff)
+			{
+				return LiteralCode(lane, __builtin_ctzll(diff));
+			}
+		}
+		return -1;
+	}
+
+	//the code of the smallest literal, -1 for the empty uc
+	inline int FirstLiteral() const
+	{
+		for (int i = 0; i < m_numLanes; ++i)
+		{
+			if (m_lanes[i].care)
+			{
+				return LiteralCode(m_lanes[i], __builtin_ctzll(m_lanes[i].care));
+			}
+		}
+		return -1;
+	}
+
+private:
+	inline int LiteralCode(const PackedLane& lane, int pos) const
+	{
+		return 2*(64*lane.index + pos) + ((lane.value >> pos) & 1 ? 0 : 1);
+	}
+
+	const PackedLane* m_lanes;
+	int m_numLanes;
+};
+
+}//namespace car
+
+#endif
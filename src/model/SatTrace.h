@@ -0,0 +1,170 @@
+#ifndef SATTRACE_H
+#define SATTRACE_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <memory>
+
+namespace car
+{
+
+///
+//a compact binary log of the calls a solver gets, so that they can be replayed against any backend.
+//a trace is the magic "CART" and a version byte, then records of one op byte each:
+//	'n'  a new solver starts, the records after it go to a fresh solver
+//	'c'  a clause: the number of literals and the literals
+//	's'  a solve: the number of assumptions, the assumptions, the result (0 UNSAT, 1 SAT, 2 unknown)
+//	     and the microseconds the recorded solve took
+//numbers are LEB128 varints, literals are zigzag coded first.
+///
+class SatTrace
+{
+public:
+	enum Op
+	{
+		NewSolver = 'n',
+		Clause = 'c',
+		Solve = 's'
+	};
+
+	enum Result
+	{
+		Unsat = 0,
+		Sat = 1,
+		Unknown = 2
+	};
+
+	SatTrace(const std::string& path)
+	{
+		m_out.open(path, std::ios::binary | std::ios::trunc);
+		m_out.write("CART", 4);
+		m_out.put(1);
+	}
+
+	~SatTrace()
+	{
+		m_out.close();
+	}
+
+	inline void BeginSolver() {m_out.put(NewSolver);}
+
+	template <class Iterator>
+	void AddClause(Iterator begin, Iterator end)
+	{
+		m_out.put(Clause);
+		PutLiterals(begin, end);
+	}
+
+	template <class Iterator>
+	void AddSolve(Iterator begin, Iterator end, Result result, uint64_t micros)
+	{
+		m_out.put(Solve);
+		PutLiterals(begin, end);
+		m_out.put(result);
+		PutNumber(micros);
+	}
+
+private:
+	template <class Iterator>
+	void PutLiterals(Iterator begin, Iterator end)
+	{
+		PutNumber(end - begin);
+		for (Iterator it = begin; it != end; ++it)
+		{
+			int lit = *it;
+			PutNumber(lit < 0 ? ((uint64_t)-(int64_t)lit << 1) - 1 : (uint64_t)lit << 1);
+		}
+	}
+
+	void PutNumber(uint64_t n)
+	{
+		while (n >= 0x80)
+		{
+			m_out.put((char)(n | 0x80));
+			n >>= 7;
+		}
+		m_out.put((char)n);
+	}
+
+	std::ofstream m_out;
+};
+
+///
+//reads back the records of a trace one by one
+///
+class SatTraceReader
+{
+public:
+	struct Record
+	{
+		char op;
+		std::vector<int> literals;//the clause or the assumptions
+		int result;
+		uint64_t micros;
+	};
+
+	SatTraceReader(const std::string& path)
+	{
+		m_in.open(path, std::ios::binary);
+		char magic[5] = {0};
+		m_in.read(magic, 5);
+		m_valid = m_in && std::string(magic, 4) == "CART" && magic[4] == 1;
+	}
+
+	inline bool IsValid() const {return m_valid;}
+
+	bool Next(Record& record)
+	{
+		int op = m_in.get();
+		if (op == EOF)
+		{
+			return false;
+		}
+		record.op = op;
+		record.literals.clear();
+		if (op == SatTrace::NewSolver)
+		{
+			return true;
+		}
+		uint64_t size = GetNumber();
+		record.literals.reserve(size);
+		for (uint64_t i = 0; i < size; ++i)
+		{
+			uint64_t n = GetNumber();
+			record.literals.push_back((n & 1) ? -(int)((n + 1) >> 1) : (int)(n >> 1));
+		}
+		if (op == SatTrace::Solve)
+		{
+			record.result = m_in.get();
+			record.micros = GetNumber();
+		}
+		return (bool)m_in;
+	}
+
+private:
+	uint64_t GetNumber()
+	{
+		uint64_t n = 0;
+		int shift = 0, byte;
+		do
+		{
+			byte = m_in.get();
+			if (byte == EOF)
+			{
+				return n;
+			}
+			n |= (uint64_t)(byte & 0x7f) << shift;
+			shift += 7;
+		} while (byte & 0x80);
+		return n;
+	}
+
+	std::ifstream m_in;
+	bool m_valid;
+};
+
+}//namespace car
+
+#endif
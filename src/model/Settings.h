@@ -2,6 +2,8 @@
 #define SETTINGS_H
 
 #include<iostream>
+#include<cstdint>
+#include<string>
 
 namespace car
 {
@@ -19,6 +21,12 @@ enum RestartBehaviour
     BackToHalf
 };
 
+enum SatBackend
+{
+    Minisat = 0,
+    Cadical
+};
+
 struct Settings
 {
     bool debug = false;
@@ -34,11 +42,38 @@ struct Settings
     bool inputS = false;
     bool luby = false;
     bool Visualization = false;
+    bool trace = false;
+    bool simplify = false;
+    bool mergeEquivalences = false;
+    bool lazyInputs = false;
+    bool reuseFrames = false;
     float growthRate = 1.5;
     int threshold = 64;
     int timelimit = 0;
+    int unroll = 1;
+    //-portfolio runs several configurations on this many threads, 0 for one per core
+    bool portfolio = false;
+    int threads = 0;
+    //the portfolio worker these settings belong to, -1 outside a portfolio
+    int worker = -1;
+    //-jobs checks this many properties at once, each one with a share of the time left
+    int jobs = 1;
+    //-explore has this many threads steal the states of a backward check from each other, 1 for the working stack alone
+    int explore = 1;
+    //the only output a check covers, its time limit is all its own; -1 for every output
+    int property = -1;
     RestartCondition condition = RestartCondition::UcNums;
     RestartBehaviour behaviour = RestartBehaviour::BackToInit; 
+    //the backend of each solver role
+    SatBackend mainSat = SatBackend::Minisat;
+    SatBackend invSat = SatBackend::Minisat;
+    SatBackend startSat = SatBackend::Minisat;
+    SatBackend partialSat = SatBackend::Minisat;
+    //the conflicts and propagations a single query may take before the check gives up, -1 for no budget
+    int64_t conflictBudget = -1;
+    int64_t propagationBudget = -1;
+    //the SAT queries one core minimization (-muc) may take, -1 for no limit
+    int mucBudget = 256;
     std::string aigFilePath;
     std::string outputDir;
     std::string cexFilePath;
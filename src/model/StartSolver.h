@@ -1,63 +1,49 @@
 #ifndef STARTSOLVER_H
 #define STARTSOLVER_H
 
-#include "CarSolver.h"
-#include "Solver.h"
+#include "MainSolver.h"
 #include "AigerModel.h"
 #include <memory>
 namespace car
 {
 
-class StartSolver : public CarSolver
+class StartSolver
 {
 public:
-    StartSolver(std::shared_ptr<AigerModel> model, int badId)
+    StartSolver(std::shared_ptr<AigerModel> model, int badId, SatBackend backend = SatBackend::Minisat, std::shared_ptr<SatTrace> trace = nullptr)
     {
+        m_solver = NewSolver(backend, trace);
         m_model = model;
-        m_maxFlag = model->GetMaxId()+1;
-		auto& clause = m_model->GetClause();
-		for (int i = 0; i < model->GetLatchesStart(); ++i)
-		{
-			CarSolver::AddClause(clause[i]);
-		}
-        m_assumptions.push(GetLit(badId));
+        m_maxFlag = model->GetMaxId()*2+1;
+		m_solver->AddClauses(m_model->GetClause(), 0, model->GetLatchesStart(), 0);
+        m_solver->AddAssumption(badId);
+        m_numAssumptions = 1;
     }
 
     ~StartSolver(){;};
 
+    inline bool SolveWithAssumption() {return m_solver->SolveWithAssumption();}
+
+    inline ISolver& GetSolver() {return *m_solver;}
+
+    //the inputs of the last start state, also when the state keeps none
+    std::shared_ptr<std::vector<int> > GetStartInputs() {return GetInputs(*m_solver->GetModel());}
+
     std::shared_ptr<State> GetStartState()
     {
-        assert(m_model->GetNumInputs() < nVars());
-        std::shared_ptr<std::vector<int> > inputs(new std::vector<int>());
+        std::shared_ptr<std::vector<int> > model = m_solver->GetModel();
+        assert(m_model->GetNumInputs() < model->size());
+        std::shared_ptr<std::vector<int> > inputs = State::keepInputs ? GetInputs(*model) : nullptr;
         std::shared_ptr<std::vector<int> > latches(new std::vector<int>());
-        inputs->reserve(m_model->GetNumInputs());
         latches->reserve(m_model->GetNumLatches());
-        for (int i = 0; i <m_model->GetNumInputs(); ++i)
-        {
-            if (model[i] == l_True)
-            {
-                inputs->emplace_back(i+1);
-            }
-            else if (model[i] == l_False)
-            {
-                inputs->emplace_back(-i-1);
-            }
-        }
         for (int i = m_model->GetNumInputs(), end = m_model->GetNumInputs() + m_model->GetNumLatches(); i < end; ++i)
         {
-            int val;
-            if (model[i] == l_True)
-            {
-                val = i+1;
-            }
-            else if (model[i] == l_False)
-            {
-                val = -i-1;
-            }
-            if (abs(val) <= end)
+            if (!m_model->IsInCone(i+1))
             {
-                latches->push_back(val);
+                continue;
             }
+            //an unassigned latch is taken as false
+            latches->push_back(i < model->size() && model->at(i) > 0 ? i+1 : -i-1);
         }
 
         std::shared_ptr<State> newState(new State(nullptr, inputs, latches, 0));
@@ -66,36 +52,70 @@ public:
 
     void UpdateStartSolverFlag()
     {
-        if (m_assumptions.size() <= 1)
+        if (m_numAssumptions <= 1)
         {
-            m_assumptions.push(GetLit(m_maxFlag));
+            m_solver->AddAssumption(m_maxFlag);
+            ++m_numAssumptions;
         }
         else
         {
-            m_assumptions.pop();
-            m_assumptions.push(GetLit(-m_maxFlag));
-            m_assumptions.push(GetLit(++m_maxFlag));
+            m_solver->PopAssumption();
+            m_solver->AddAssumption(-m_maxFlag);
+            m_solver->AddAssumption(++m_maxFlag);
+            ++m_numAssumptions;
         }
     }
 
     void AddClause(int flag, std::vector<int>& clause)
     {
-        vec<Lit> literals;
-        literals.push(GetLit(flag));
+        std::vector<int> literals;
+        literals.reserve(clause.size() + 1);
+        literals.push_back(flag);
         for (int i = 0; i < clause.size(); ++i)
         {
-            literals.push(GetLit(-clause[i]));
+            literals.push_back(-clause[i]);
         }
-        bool result = addClause(literals);
-        assert (result != false);
+        m_solver->AddClause(literals);
+    }
+
+    //blocks the cube under every flag, for a cube no state is reached in
+    void AddPermanentClause(const std::vector<int>& cube)
+    {
+        std::vector<int> literals;
+        literals.reserve(cube.size());
+        for (int i = 0; i < cube.size(); ++i)
+        {
+            literals.push_back(-cube[i]);
+        }
+        m_solver->AddClause(literals);
     }
 
     inline int GetFlag() {return m_maxFlag;}
 
+private:
+    std::shared_ptr<std::vector<int> > GetInputs(const std::vector<int>& model)
+    {
+        std::shared_ptr<std::vector<int> > inputs(new std::vector<int>());
+        inputs->reserve(m_model->GetNumInputs());
+        for (int i = 0; i <m_model->GetNumInputs(); ++i)
+        {
+            if (model[i] != 0)
+            {
+                inputs->emplace_back(model[i]);
+            }
+        }
+        return inputs;
+    }
+
+    std::shared_ptr<ISolver> m_solver;
+    std::shared_ptr<AigerModel> m_model;
+    int m_maxFlag;
+    int m_numAssumptions;//the bad literal and the flags assumed so far
+
 };//class StartSolver
 
 
 }//namespace car
 
 
-#endif
\ No newline at end of file
+#endif
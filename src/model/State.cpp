@@ -4,22 +4,22 @@ namespace car
 {
 	int State::numInputs = -1;
     int State::numLatches = -1;
+    bool State::keepInputs = true;
 
     std::string State::GetValueOfLatches()
 	{
 		std::string result = "";
 		result.reserve(numLatches);
-		int j = 0;
 		for (int i = 0; i < State::numLatches; ++i)
 		{
-			if (State::numInputs + i + 1 < abs((*latches)[j]))
+			uint64_t bit = 1ull << (i & 63);
+			if (!(latches.Care(i >> 6) & bit))
 			{
 				result += "x";
 			}
 			else
 			{
-				result += (latches->at(j) > 0) ? "1" : "0";
-				++j;
+				result += (latches.Value(i >> 6) & bit) ? "1" : "0";
 			}
 		}
 		return result;
@@ -5,6 +5,7 @@
 #include <string>
 #include <stdlib.h>
 #include <memory>
+#include "PackedCube.h"
 namespace car
 {
 
@@ -12,7 +13,7 @@ class State
 {
 public:
 	State(std::shared_ptr<State> inPreState, std::shared_ptr<std::vector<int> > inInputs, std::shared_ptr<std::vector<int> > inLatches, int inDepth):
-		preState(inPreState), inputs(inInputs), latches(inLatches), depth(inDepth)
+		preState(inPreState), inputs(keepInputs ? inInputs : nullptr), latches(*inLatches, numInputs, numLatches), depth(inDepth)
 	{
 		
 	}
@@ -20,12 +21,23 @@ public:
 	std::string GetValueOfLatches();
 
 	std::string GetValueOfInputs();
+
+	//unpacked latches, e.g. to build an assumption
+	std::shared_ptr<std::vector<int> > GetLatches() {return latches.ToVector(numInputs, numLatches);}
+
+	//the same literals added to a vector kept by the caller, e.g. the assumption of every query
+	inline void AppendLatches(std::vector<int>& out) {latches.AppendTo(out, numInputs, numLatches);}
+
+	inline bool HasLiteral(int lit) {return latches.HasLiteral(lit, numInputs);}
+
 	static int numInputs;
 	static int numLatches;
+	//off, the inputs are only found again for a counterexample (Log::PrintInputs)
+	static bool keepInputs;
 	int depth;
 	std::shared_ptr<State> preState = nullptr;
 	std::shared_ptr<std::vector<int> > inputs;
-	std::shared_ptr<std::vector<int> > latches;
+	PackedState latches;
 	
 };
 
@@ -0,0 +1,137 @@
+#ifndef UCARENA_H
+#define UCARENA_H
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+
+namespace car
+{
+
+///
+//the literals of one uc, read in place from wherever they are stored (a vector or a UcArena)
+///
+class Lemma
+{
+public:
+	Lemma(): m_data(nullptr), m_size(0) {}
+
+	Lemma(const int* data, int size): m_data(data), m_size(size) {}
+
+	Lemma(const std::vector<int>& uc): m_data(uc.data()), m_size(uc.size()) {}
+
+	inline int size() const {return m_size;}
+
+	inline bool empty() const {return m_size == 0;}
+
+	inline int operator[](int i) const {return m_data[i];}
+
+	inline const int* begin() const {return m_data;}
+
+	inline const int* end() const {return m_data + m_size;}
+
+	std::shared_ptr<std::vector<int> > ToVector() const
+	{
+		return std::shared_ptr<std::vector<int> >(new std::vector<int>(begin(), end()));
+	}
+
+private:
+	const int* m_data;
+	int m_size;
+};
+
+//ucs are sorted by latch, so equal ucs hash equally
+inline uint64_t HashLemma(const Lemma& uc)
+{
+	uint64_t res = uc.size();
+	for (int i = 0; i < uc.size(); ++i)
+	{
+		res ^= (uint64_t)(uint32_t)uc[i] + 0x9e3779b97f4a7c15ull + (res << 6) + (res >> 2);
+	}
+	//splitmix64 finalizer, so that sums of hashes stay well spread
+	res ^= res >> 30; res *= 0xbf58476d1ce4e5b9ull;
+	res ^= res >> 27; res *= 0x94d049bb133111ebull;
+	res ^= res >> 31;
+	return res;
+}
+
+///
+//append-only storage of the ucs of one frame: all literals live in one vector, each uc is an offset and a length into it.
+//removed ucs leave their literals behind until they make up half of the arena, then the live ones are moved
+//to the front and the generation goes up. a Lemma read from the arena is valid within one generation.
+///
+class UcArena
+{
+public:
+	UcArena(): m_dead(0), m_generation(0) {}
+
+	void Push(const Lemma& uc)
+	{
+		m_offsets.push_back(m_literals.size());
+		m_sizes.push_back(uc.size());
+		m_literals.insert(m_literals.end(), uc.begin(), uc.end());
+	}
+
+	inline Lemma operator[](int i) const {return Lemma(m_literals.data() + m_offsets[i], m_sizes[i]);}
+
+	inline Lemma back() const {return (*this)[size() - 1];}
+
+	inline int size() const {return m_offsets.size();}
+
+	inline bool empty() const {return m_offsets.empty();}
+
+	inline int GetGeneration() const {return m_generation;}
+
+	//drops in place the ucs whose keep flag is false, the others keep their order
+	void RemoveIf(const std::vector<bool>& keep)
+	{
+		int j = 0;
+		for (int i = 0; i < m_offsets.size(); ++i)
+		{
+			if (keep[i])
+			{
+				m_offsets[j] = m_offsets[i];
+				m_sizes[j] = m_sizes[i];
+				++j;
+			}
+			else
+			{
+				m_dead += m_sizes[i];
+			}
+		}
+		m_offsets.resize(j);
+		m_sizes.resize(j);
+		if (2*m_dead > m_literals.size())
+		{
+			Reclaim();
+		}
+	}
+
+private:
+	void Reclaim()
+	{
+		//offsets only grow, so moving every uc towards the front never overwrites a live one
+		int end = 0;
+		for (int i = 0; i < m_offsets.size(); ++i)
+		{
+			std::copy(m_literals.begin() + m_offsets[i], m_literals.begin() + m_offsets[i] + m_sizes[i], m_literals.begin() + end);
+			m_offsets[i] = end;
+			end += m_sizes[i];
+		}
+		m_literals.resize(end);
+		m_literals.shrink_to_fit();
+		m_dead = 0;
+		++m_generation;
+	}
+
+	std::vector<int> m_literals;
+	std::vector<int> m_offsets;//the i-th uc starts at m_literals[m_offsets[i]]
+	std::vector<int> m_sizes;
+	int m_dead;//the number of literals of removed ucs still in m_literals
+	int m_generation;
+};
+
+}//namespace car
+
+#endif
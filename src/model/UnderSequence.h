@@ -4,6 +4,7 @@
 #include "State.h"
 #include <iostream>
 #include <vector>
+#include <unordered_map>
 namespace car
 {
 
@@ -20,33 +21,42 @@ public:
             }
         }
     }
-    void push(std::shared_ptr<State> state)
+
+    //returns the state the sequence keeps for these latches: state itself if it is new,
+    //else the one reached before, which stays where it is and is counted as a repeat
+    std::shared_ptr<State> push(std::shared_ptr<State> state)
     {
+        uint64_t hash = state->latches.Hash();
+        auto range = m_visited.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second->latches == state->latches)
+            {
+                ++m_repeats;
+                return it->second;
+            }
+        }
+        m_visited.emplace(hash, state);
         while(m_sequence.size() <= state->depth)
         {
             m_sequence.emplace_back(std::vector<std::shared_ptr<State> >());
         }
         m_sequence[state->depth].push_back(state);
+        return state;
     }
 
-    bool isRepeatedState(std::shared_ptr<State> state){
-        for (int i = 0; i < m_sequence.size(); ++i){
-                for (int j = 0; j < m_sequence[i].size(); j++){
-                    for (int k = 0; k < state->latches->size(); k++){
-                        if (m_sequence[i][j]->latches->at(k) != state->latches->at(k)) return false;
-                    }
-                    return true;
-                }
-            }
-    }
+    //how many pushed states had been reached before
+    inline int GetRepeats() const {return m_repeats;}
 
     int size() {return m_sequence.size();}
 
     std::vector<std::shared_ptr<State> >& operator[] (int i) {return m_sequence[i];}
 private:
     std::vector<std::vector<std::shared_ptr<State> > > m_sequence;
+    std::unordered_multimap<uint64_t, std::shared_ptr<State> > m_visited;//by the hash of the packed latches
+    int m_repeats = 0;
 };
 
 }//namespace car
 
-#endif
\ No newline at end of file
+#endif
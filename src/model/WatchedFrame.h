@@ -0,0 +1,172 @@
+#ifndef WATCHEDFRAME_H
+#define WATCHEDFRAME_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "PackedCube.h"
+
+namespace car
+{
+
+///
+//the packed ucs of one frame, indexed by one watched literal per uc.
+//a state only visits the ucs whose watched literal it agrees with. when such a uc does not block the state,
+//its watch moves to a literal the state disagrees with, so the next (usually similar) state skips it.
+///
+class WatchedFrame
+{
+public:
+	WatchedFrame(): m_numEmpty(0) {}
+
+	void Push(const Lemma& uc, int numInputs)
+	{
+		int offset = m_lanes.size();
+		int numLanes = PackedUc::Pack(uc, numInputs, m_lanes);
+		m_laneOffsets.push_back(offset);
+		m_laneCounts.push_back(numLanes);
+		PackedUc packed = GetUc(m_laneOffsets.size() - 1);
+		int watch = packed.FirstLiteral();
+		Reserve(packed.GetLastLane() + 1);
+		m_watches.push_back(watch);
+		if (watch < 0)
+		{
+			++m_numEmpty;
+		}
+		else
+		{
+			Watch(m_watches.size() - 1, watch);
+		}
+	}
+
+	//drops in place the ucs whose keep flag is false, the others keep their watches
+	void RemoveIf(const std::vector<bool>& keep)
+	{
+		int j = 0, end = 0;
+		for (int i = 0; i < m_watches.size(); ++i)
+		{
+			if (keep[i])
+			{
+				std::copy(m_lanes.begin() + m_laneOffsets[i], m_lanes.begin() + m_laneOffsets[i] + m_laneCounts[i], m_lanes.begin() + end);
+				m_laneOffsets[j] = end;
+				m_laneCounts[j] = m_laneCounts[i];
+				m_watches[j] = m_watches[i];
+				end += m_laneCounts[i];
+				++j;
+			}
+		}
+		m_lanes.resize(end);
+		m_laneOffsets.resize(j);
+		m_laneCounts.resize(j);
+		m_watches.resize(j);
+		for (int i = 0; i < m_watchLists.size(); ++i)
+		{
+			m_watchLists[i].clear();
+		}
+		std::fill(m_watchedPos.begin(), m_watchedPos.end(), 0);
+		std::fill(m_watchedNeg.begin(), m_watchedNeg.end(), 0);
+		m_numEmpty = 0;
+		for (int i = 0; i < m_watches.size(); ++i)
+		{
+			if (m_watches[i] < 0)
+			{
+				++m_numEmpty;
+			}
+			else
+			{
+				Watch(i, m_watches[i]);
+			}
+		}
+	}
+
+	inline int Size() const {return m_watches.size();}
+
+	inline PackedUc GetUc(int i) const {return PackedUc(m_lanes.data() + m_laneOffsets[i], m_laneCounts[i]);}
+
+	bool IsBlocking(const PackedState& state)
+	{
+		if (m_numEmpty > 0)
+		{
+			return true;
+		}
+		int lanes = std::min(state.GetLanes(), (int)m_watchedPos.size());
+		for (int lane = 0; lane < lanes; ++lane)
+		{
+			uint64_t pos = state.Care(lane) & state.Value(lane) & m_watchedPos[lane];
+			uint64_t neg = state.Care(lane) & ~state.Value(lane) & m_watchedNeg[lane];
+			while (pos)
+			{
+				int bit = __builtin_ctzll(pos);
+				pos &= pos - 1;
+				if (VisitWatches(2*(64*lane + bit), state))
+				{
+					return true;
+				}
+			}
+			while (neg)
+			{
+				int bit = __builtin_ctzll(neg);
+				neg &= neg - 1;
+				if (VisitWatches(2*(64*lane + bit) + 1, state))
+				{
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+private:
+	//grows the index so that every literal of the first lanes can be watched without reallocating during a visit
+	void Reserve(int lanes)
+	{
+		if (lanes > m_watchedPos.size())
+		{
+			m_watchedPos.resize(lanes, 0);
+			m_watchedNeg.resize(lanes, 0);
+			m_watchLists.resize(128*lanes);
+		}
+	}
+
+	inline void Watch(int ucIndex, int code)
+	{
+		m_watchLists[code].push_back(ucIndex);
+		uint64_t bit = 1ull << ((code >> 1) & 63);
+		((code & 1) ? m_watchedNeg : m_watchedPos)[code >> 7] |= bit;
+	}
+
+	bool VisitWatches(int code, const PackedState& state)
+	{
+		std::vector<int>& list = m_watchLists[code];
+		for (int i = 0; i < list.size();)
+		{
+			int ucIndex = list[i];
+			int conflict = GetUc(ucIndex).Conflict(state);
+			if (conflict < 0)
+			{
+				return true;
+			}
+			//the state disagrees with the conflict literal, so it is never one of the literals being visited
+			m_watches[ucIndex] = conflict;
+			Watch(ucIndex, conflict);
+			list[i] = list.back();
+			list.pop_back();
+		}
+		uint64_t bit = 1ull << ((code >> 1) & 63);
+		((code & 1) ? m_watchedNeg : m_watchedPos)[code >> 7] &= ~bit;
+		return false;
+	}
+
+	std::vector<PackedLane> m_lanes;//the lanes of all ucs, one uc after another
+	std::vector<int> m_laneOffsets;//the lanes of the i-th uc start at m_lanes[m_laneOffsets[i]]
+	std::vector<int> m_laneCounts;
+	std::vector<int> m_watches;//m_watches[i] is the code of the literal the i-th uc watches, -1 for the empty uc
+	std::vector<std::vector<int> > m_watchLists;//indexed by literal code
+	std::vector<uint64_t> m_watchedPos;//bit i of lane l is set iff the positive literal of latch 64*l+i has watches
+	std::vector<uint64_t> m_watchedNeg;
+	int m_numEmpty;
+};
+
+}//namespace car
+
+#endif
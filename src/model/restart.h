@@ -120,9 +120,10 @@ public:
         {
             return (m_ucCounts > m_threshold);
         }
+        return false;
     }
 
-    bool DoRestart(std::stack<Task>& workingStack)
+    void DoRestart(std::stack<Task>& workingStack)
     {
         if (m_behaviour == RestartBehaviour::BackToInit)
         {
@@ -0,0 +1,117 @@
+#include <cstdio>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include "MainSolver.h"
+#include "SatTrace.h"
+
+using namespace car;
+using namespace std;
+
+///
+//replays a trace recorded by simplecar -trace against a SAT backend
+//and reports the latency of the solves, next to the latency they had when recorded
+///
+
+void PrintUsage()
+{
+    printf ("Usage: simplecar_replay [-sat <minisat|cadical>] <trace file>\n");
+    exit (0);
+}
+
+double Percentile(vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+    int index = min((int)sorted.size() - 1, (int)(p * sorted.size()));
+    return sorted[index];
+}
+
+void PrintLatency(const char* name, vector<double>& micros)
+{
+    sort(micros.begin(), micros.end());
+    double total = 0;
+    for (double m : micros)
+    {
+        total += m;
+    }
+    printf ("%-10s total %.3fs  p50 %.0fus  p90 %.0fus  p99 %.0fus  max %.0fus\n", name, total/1e6,
+        Percentile(micros, 0.5), Percentile(micros, 0.9), Percentile(micros, 0.99), micros.empty() ? 0 : micros.back());
+}
+
+int main(int argc, char** argv)
+{
+    SatBackend backend = SatBackend::Minisat;
+    string tracePath;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-sat") == 0 && i+1 < argc)
+        {
+            ++i;
+            if (strcmp(argv[i], "minisat") == 0) backend = SatBackend::Minisat;
+            else if (strcmp(argv[i], "cadical") == 0) backend = SatBackend::Cadical;
+            else PrintUsage();
+        }
+        else if (tracePath.empty())
+        {
+            tracePath = argv[i];
+        }
+        else
+        {
+            PrintUsage();
+        }
+    }
+    if (tracePath.empty())
+    {
+        PrintUsage();
+    }
+
+    SatTraceReader reader(tracePath);
+    if (!reader.IsValid())
+    {
+        printf ("%s is not a trace\n", tracePath.c_str());
+        return 1;
+    }
+
+    shared_ptr<ISolver> solver;
+    SatTraceReader::Record record;
+    int numSolvers = 0, numClauses = 0, numMismatches = 0;
+    vector<double> recorded, replayed;
+    while (reader.Next(record))
+    {
+        if (record.op == SatTrace::NewSolver || solver == nullptr)
+        {
+            solver = NewSolver(backend);
+            ++numSolvers;
+        }
+        if (record.op == SatTrace::Clause)
+        {
+            solver->AddClause(record.literals);
+            ++numClauses;
+        }
+        else if (record.op == SatTrace::Solve)
+        {
+            solver->ClearAssumption();
+            for (int lit : record.literals)
+            {
+                solver->AddAssumption(lit);
+            }
+            auto begin = chrono::steady_clock::now();
+            bool result = solver->SolveWithAssumption();
+            replayed.push_back(chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - begin).count());
+            recorded.push_back(record.micros);
+            if (record.result != SatTrace::Unknown && result != (record.result == SatTrace::Sat))
+            {
+                ++numMismatches;
+            }
+        }
+    }
+
+    printf ("solvers %d  clauses %d  solves %d  mismatched results %d\n", numSolvers, numClauses, (int)replayed.size(), numMismatches);
+    PrintLatency("recorded", recorded);
+    PrintLatency("replayed", replayed);
+    return 0;
+}
@@ -32,7 +32,7 @@ namespace car{
   void Vis::addState(std::shared_ptr<State> state){
     uint temp_node_id = tempId ++;
     std::vector<uint32_t> temp_node;
-    latches_vecotr_to_short_vector(temp_node, *state->latches);
+    latches_vecotr_to_short_vector(temp_node, *state->GetLatches());
     //add node
     auto z = node_id_map.insert(std::pair<std::vector<uint32_t>, uint>(temp_node, temp_node_id));
     if (z.second == false){ // visit the same state repeatedly
@@ -56,7 +56,7 @@ namespace car{
     if (state->preState){
       //find prenode
       std::vector<uint32_t> pre_node;
-      latches_vecotr_to_short_vector(pre_node, *state->preState->latches);
+      latches_vecotr_to_short_vector(pre_node, *state->preState->GetLatches());
       std::map<std::vector<uint32_t>, uint>::iterator iter;
       iter = node_id_map.find(pre_node);
       if (iter != node_id_map.end()){